@@ -0,0 +1,74 @@
+#include "alloc_counter.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+
+std::atomic<size_t> g_allocations{ 0 };
+
+void* CountedAlloc(size_t bytes) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(bytes ? bytes : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* CountedAlignedAlloc(size_t bytes, std::align_val_t align) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    const size_t a = size_t(align);
+#ifdef _WIN32
+    void* p = _aligned_malloc(bytes ? bytes : 1, a);
+#else
+    // aligned_alloc wants a non-zero multiple of the alignment
+    void* p = std::aligned_alloc(a, std::max((bytes + a - 1) / a * a, a));
+#endif
+    if (p) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void AlignedFree(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+} // namespace
+
+size_t BabaIsYou::AllocationCount() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+// the nothrow and array forms forward to these
+void* operator new(size_t bytes) {
+    return CountedAlloc(bytes);
+}
+
+void* operator new(size_t bytes, std::align_val_t align) {
+    return CountedAlignedAlloc(bytes, align);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    AlignedFree(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    AlignedFree(p);
+}
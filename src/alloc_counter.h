@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+namespace BabaIsYou {
+
+// Heap allocations made through the global operator new since the program started. Only an
+// executable that links alloc_counter.cpp counts them, since that file replaces operator new;
+// the engine library never does.
+size_t AllocationCount();
+
+} // namespace BabaIsYou
@@ -0,0 +1,42 @@
+#include "arena.h"
+#include <cassert>
+#include <cstdint>
+
+namespace BabaIsYou {
+
+Arena::Arena(size_t capacity)
+    : m_block(std::make_unique_for_overwrite<std::byte[]>(capacity)), m_capacity(capacity) {}
+
+void* Arena::Allocate(size_t bytes, size_t align) {
+    assert(align != 0 && (align & (align - 1)) == 0);
+
+    const auto base = reinterpret_cast<uintptr_t>(m_block.get());
+    const size_t offset = ((base + m_used + align - 1) & ~(align - 1)) - base;
+    if (offset + bytes <= m_capacity) {
+        m_used = offset + bytes;
+        return m_block.get() + offset;
+    }
+
+    auto& chunk = m_chunks.emplace_back(std::make_unique_for_overwrite<std::byte[]>(bytes + align));
+    m_chunkBytes += bytes + align;
+    const auto chunkBase = reinterpret_cast<uintptr_t>(chunk.get());
+    return chunk.get() + (((chunkBase + align - 1) & ~(align - 1)) - chunkBase);
+}
+
+void Arena::Release(size_t mark) {
+    assert(mark <= m_used);
+    m_used = mark;
+    if (m_used == 0 && !m_chunks.empty()) {
+        m_capacity += m_chunkBytes;
+        m_block = std::make_unique_for_overwrite<std::byte[]>(m_capacity);
+        m_chunks.clear();
+        m_chunkBytes = 0;
+    }
+}
+
+Arena& TurnArena() {
+    thread_local Arena arena;
+    return arena;
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace BabaIsYou {
+
+// Bump allocator for scratch memory that lives no longer than a turn. Allocating moves a pointer
+// and nothing is freed on its own: a Scope hands back everything allocated since it opened.
+//
+// A turn that outgrows the block gets extra chunks from the heap. Once the arena is empty again
+// it swaps block and chunks for one block of their combined size, so a steady workload stops
+// allocating after its first few turns.
+class Arena {
+  public:
+    explicit Arena(size_t capacity = 64 * 1024);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* Allocate(size_t bytes, size_t align);
+
+    // Uninitialized storage for `count` objects
+    template <typename T>
+    std::span<T> Allocate(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena memory is never destroyed");
+        return { static_cast<T*>(Allocate(count * sizeof(T), alignof(T))), count };
+    }
+
+    // Releases everything allocated since it was opened
+    class Scope {
+      public:
+        explicit Scope(Arena& arena) : m_arena(arena), m_mark(arena.m_used) {}
+        ~Scope() { m_arena.Release(m_mark); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        template <typename T>
+        std::span<T> Allocate(size_t count) {
+            return m_arena.Allocate<T>(count);
+        }
+
+      private:
+        Arena& m_arena;
+        size_t m_mark;
+    };
+
+  private:
+    void Release(size_t mark);
+
+    std::unique_ptr<std::byte[]> m_block;
+    size_t m_capacity;
+    size_t m_used = 0;
+
+    std::vector<std::unique_ptr<std::byte[]>> m_chunks; // overflow of the current turn
+    size_t m_chunkBytes = 0;
+};
+
+// The calling thread's arena for turn scratch
+Arena& TurnArena();
+
+} // namespace BabaIsYou
@@ -0,0 +1,133 @@
+#include "baba_env.h"
+#include "change_set.h"
+#include "engine.h"
+#include "game_state.h"
+#include "level.h"
+#include "observation.h"
+#include <exception>
+#include <memory>
+
+struct BabaEnv {
+    BabaIsYou::Engine engine;
+    BabaIsYou::GameState start;
+    BabaIsYou::GameState state;
+
+    BabaIsYou::ObservationEncoder encoder{ engine };
+    BabaIsYou::ChangeSet changes;
+    uint8_t* planesU8 = nullptr; // bound plane buffer, at most one of the two
+    float* planesF32 = nullptr;
+};
+
+using namespace BabaIsYou;
+
+namespace {
+
+void EncodePlanes(BabaEnv* env) {
+    if (env->planesU8) {
+        env->encoder.Encode(env->state, env->planesU8);
+    } else if (env->planesF32) {
+        env->encoder.Encode(env->state, env->planesF32);
+    }
+}
+
+} // namespace
+
+int baba_num_levels(void) {
+    return LevelManager().Count();
+}
+
+BabaEnv* baba_create(int level) {
+    // nothing may throw across the C boundary
+    try {
+        LevelManager levels;
+        if (level < 0 || level >= levels.Count()) {
+            return nullptr;
+        }
+
+        auto env = std::make_unique<BabaEnv>();
+        levels.SelectLevel(level, env->start);
+        env->state = env->start;
+        return env.release();
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+void baba_destroy(BabaEnv* env) {
+    delete env;
+}
+
+void baba_reset(BabaEnv* env) {
+    env->state = env->start;
+    EncodePlanes(env);
+}
+
+int baba_step(BabaEnv* env, int action, float* reward, int* done) {
+    if (action < 0 || action >= BABA_NUM_ACTIONS) {
+        return -1;
+    }
+
+    const bool wasWin = env->state.IsWin();
+    if (!wasWin) {
+        env->changes.Clear();
+        env->engine.Step(env->state, Direction(action), &env->changes);
+        if (env->planesU8) {
+            env->encoder.Update(env->state, env->changes, env->planesU8);
+        } else if (env->planesF32) {
+            env->encoder.Update(env->state, env->changes, env->planesF32);
+        }
+    }
+
+    const bool isWin = env->state.IsWin();
+    if (reward) {
+        *reward = isWin && !wasWin ? 1.0f : 0.0f;
+    }
+    if (done) {
+        *done = isWin ? 1 : 0;
+    }
+    return 0;
+}
+
+size_t baba_observation_width(void) {
+    return LEVEL_WIDTH;
+}
+
+size_t baba_observation_height(void) {
+    return LEVEL_HEIGHT;
+}
+
+size_t baba_observation_size(void) {
+    return NUM_TILES;
+}
+
+void baba_get_observation(const BabaEnv* env, uint16_t* buffer) {
+    for (int y = 0; y < LEVEL_HEIGHT; ++y) {
+        for (int x = 0; x < LEVEL_WIDTH; ++x) {
+            uint16_t mask = 0;
+            for (const auto obj : env->state.At(x, y)) {
+                mask |= uint16_t(1u << int(obj));
+            }
+            buffer[ToIndex(x, y)] = mask;
+        }
+    }
+}
+
+size_t baba_num_planes(void) {
+    return NUM_OBSERVATION_PLANES;
+}
+
+size_t baba_planes_size(void) {
+    return OBSERVATION_SIZE;
+}
+
+void baba_bind_planes_u8(BabaEnv* env, uint8_t* buffer) {
+    env->planesU8 = buffer;
+    env->planesF32 = nullptr;
+    EncodePlanes(env);
+}
+
+void baba_bind_planes_f32(BabaEnv* env, float* buffer) {
+    env->planesU8 = nullptr;
+    env->planesF32 = buffer;
+    EncodePlanes(env);
+}
@@ -0,0 +1,75 @@
+/* Plain C interface to the headless engine for training harnesses: one environment per handle,
+ * reset/step/observe, no window and no raylib. Handles are independent, so different threads may
+ * drive different handles; a single handle must not be used from two threads at once. Stepping,
+ * resetting and observing do not allocate once warm: the first steps after a reset copy the
+ * board blocks they change, from a per-thread pool that allocates only until it has grown. */
+
+#ifndef BABA_ENV_H
+#define BABA_ENV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(BABA_ENV_BUILD)
+#define BABA_API __declspec(dllexport)
+#else
+#define BABA_API __declspec(dllimport)
+#endif
+#else
+#define BABA_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct BabaEnv BabaEnv;
+
+enum BabaAction {
+    BABA_ACTION_UP = 0,
+    BABA_ACTION_DOWN = 1,
+    BABA_ACTION_LEFT = 2,
+    BABA_ACTION_RIGHT = 3,
+    BABA_NUM_ACTIONS = 4
+};
+
+/* Number of built-in levels; valid levels are 0 .. count - 1 */
+BABA_API int baba_num_levels(void);
+
+/* NULL if `level` is out of range or the handle could not be allocated */
+BABA_API BabaEnv* baba_create(int level);
+BABA_API void baba_destroy(BabaEnv* env);
+
+/* Back to the start of the level */
+BABA_API void baba_reset(BabaEnv* env);
+
+/* Applies `action`. `reward` is 1 on the step that wins and 0 otherwise, `done` is 1 once the
+ * level is won. Either pointer may be NULL. Returns 0, or -1 for an invalid action. */
+BABA_API int baba_step(BabaEnv* env, int action, float* reward, int* done);
+
+/* Observation: one uint16 per tile, row by row, with bit t set when an object of type t is on it.
+ * `buffer` must hold baba_observation_size() elements. */
+BABA_API size_t baba_observation_width(void);
+BABA_API size_t baba_observation_height(void);
+BABA_API size_t baba_observation_size(void);
+BABA_API void baba_get_observation(const BabaEnv* env, uint16_t* buffer);
+
+/* One-hot planes: baba_num_planes() planes of width x height values, plane by plane, row by row.
+ * The first planes are one per object type (plane 0 marks empty tiles), then one per property:
+ * You, Stop, Win, Push. */
+BABA_API size_t baba_num_planes(void);
+BABA_API size_t baba_planes_size(void);
+
+/* Binds a buffer of baba_planes_size() elements that the handle keeps current without copies: it
+ * is filled on binding and on reset, and each step rewrites only the tiles that step changed. The
+ * buffer must stay valid while bound; pass NULL to unbind. A handle has at most one buffer, so
+ * binding one unbinds any other. */
+BABA_API void baba_bind_planes_u8(BabaEnv* env, uint8_t* buffer);
+BABA_API void baba_bind_planes_f32(BabaEnv* env, float* buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
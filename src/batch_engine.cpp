@@ -0,0 +1,258 @@
+#include "batch_engine.h"
+#include "trace.h"
+#include <cassert>
+
+namespace BabaIsYou {
+
+namespace {
+
+// Off-board tiles block like Stop whatever the rules say
+constexpr TileMask EDGE_BIT = TileMask(1) << NUM_OBJECT_TYPES;
+
+constexpr TileMask Bit(ObjectType type) {
+    return TileMask(1) << int(type);
+}
+
+TileMask MaskOf(const std::vector<ObjectType>& types) {
+    TileMask mask = 0;
+    for (const auto type : types) {
+        mask |= Bit(type);
+    }
+    return mask;
+}
+
+// all ones when any bit of `mask` is set in `tile`
+inline TileMask AnyOf(TileMask tile, TileMask mask) {
+    return TileMask(-TileMask((tile & mask) != 0));
+}
+
+} // namespace
+
+BatchEngine::BatchEngine(const Engine& engine, size_t numEnvs)
+    : m_numEnvs(numEnvs), m_numPadded((numEnvs + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES) {
+    const auto& rules = engine.GetRules();
+    m_youMask = MaskOf(rules.Get(Property::You));
+    m_pushMask = MaskOf(rules.Get(Property::Push));
+    m_stopMask = MaskOf(rules.Get(Property::Stop)) | EDGE_BIT;
+    m_winMask = MaskOf(rules.Get(Property::Win));
+
+    for (const Direction dir : DIRECTIONS) {
+        const auto [dx, dy] = ToDelta(dir);
+        auto& ahead = m_ahead[int(dir)];
+        ahead.resize(NUM_TILES);
+        for (int tile = 0; tile < NUM_TILES; ++tile) {
+            const auto [x, y] = ToPos(uint16_t(tile));
+            for (int k = 0; k < BATCH_WINDOW; ++k) {
+                const int cx = x + k * dx;
+                const int cy = y + k * dy;
+                const bool inBounds = cx >= 0 && cx < LEVEL_WIDTH && cy >= 0 && cy < LEVEL_HEIGHT;
+                ahead[tile][k] = inBounds ? ToIndex(cx, cy) : uint16_t(NUM_TILES);
+            }
+        }
+    }
+
+    m_boards.assign(m_numEnvs * STRIDE, 0);
+    for (size_t env = 0; env < m_numEnvs; ++env) {
+        Board(env)[NUM_TILES] = EDGE_BIT;
+    }
+    m_you.assign(m_numEnvs, NO_YOU);
+    m_wins.assign(m_numEnvs, 0);
+
+    for (auto& slot : m_window) {
+        slot.assign(m_numPadded, 0);
+    }
+    m_moved.assign(m_numPadded, 0);
+    m_overflow.assign(m_numPadded, 0);
+}
+
+bool BatchEngine::SetState(size_t env, const GameState& gs) {
+    assert(env < m_numEnvs);
+
+    uint16_t you = NO_YOU;
+    for (int type = 0; type < NUM_OBJECT_TYPES; ++type) {
+        if ((m_youMask & Bit(ObjectType(type))) == 0) {
+            continue;
+        }
+        for (const auto index : gs.Positions(ObjectType(type))) {
+            if (you != NO_YOU) {
+                return false;
+            }
+            you = index;
+        }
+    }
+
+    TileMask* board = Board(env);
+    for (int y = 0; y < LEVEL_HEIGHT; ++y) {
+        for (int x = 0; x < LEVEL_WIDTH; ++x) {
+            TileMask mask = 0;
+            for (const auto obj : gs.At(x, y)) {
+                mask |= Bit(obj);
+            }
+            board[ToIndex(x, y)] = mask;
+        }
+    }
+
+    m_you[env] = you;
+    m_wins[env] = gs.IsWin();
+    return true;
+}
+
+void BatchEngine::GetState(size_t env, GameState& gs) const {
+    assert(env < m_numEnvs);
+
+    const TileMask* board = Board(env);
+    gs.Clear();
+    for (int y = 0; y < LEVEL_HEIGHT; ++y) {
+        for (int x = 0; x < LEVEL_WIDTH; ++x) {
+            for (ObjectType type = ObjectType::Empty; type < ObjectType::NumType; ++type) {
+                if (board[ToIndex(x, y)] & Bit(type)) {
+                    gs.Push(x, y, type);
+                }
+            }
+        }
+    }
+    gs.SetWin(m_wins[env]);
+}
+
+void BatchEngine::Step(std::span<const Direction> actions, size_t first, size_t last) {
+    TRACE_ZONE("BatchEngine::Step");
+    assert(actions.size() == m_numEnvs);
+    assert(first % BATCH_LANES == 0 && (last % BATCH_LANES == 0 || last == m_numEnvs));
+    assert(last <= m_numEnvs);
+
+    Gather(actions, first, last);
+    Resolve(first, last);
+    Scatter(actions, first, last);
+}
+
+void BatchEngine::Gather(std::span<const Direction> actions, size_t first, size_t last) {
+    for (size_t env = first; env < last; ++env) {
+        const uint16_t you = m_you[env];
+        if (you == NO_YOU) {
+            m_window[0][env] = 0;
+            continue;
+        }
+
+        const TileMask* board = Board(env);
+        const auto& ahead = m_ahead[int(actions[env])][you];
+        for (int k = 0; k < BATCH_WINDOW; ++k) {
+            m_window[k][env] = board[ahead[k]];
+        }
+    }
+}
+
+// Window slot 0 holds the You, slots 1.. the tiles ahead. With chainOk(k) true when a push chain
+// starting at slot k can advance:
+//   chainOk(k) = push(k) ? chainOk(k + 1) : !stop(k)
+//   moves      = you(0) && !stop(1) && chainOk(1)
+// and a moving You shifts the push objects of the contiguous push run from slot 1 one slot ahead.
+void BatchEngine::Resolve(size_t first, size_t last) {
+    const TileMask you = m_youMask;
+    const TileMask push = m_pushMask;
+    const TileMask stop = m_stopMask;
+
+    for (size_t base = first; base < last; base += BATCH_LANES) {
+        std::array<TileMask, BATCH_LANES> ok{};
+        std::array<TileMask, BATCH_LANES> allPush;
+        allPush.fill(TileMask(~0));
+
+        for (int k = BATCH_WINDOW - 1; k >= 1; --k) {
+            const TileMask* w = m_window[k].data() + base;
+            for (size_t l = 0; l < BATCH_LANES; ++l) {
+                const TileMask isPush = AnyOf(w[l], push);
+                const TileMask notStop = TileMask(~AnyOf(w[l], stop));
+                ok[l] = TileMask((isPush & ok[l]) | (~isPush & notStop));
+                allPush[l] &= isPush;
+            }
+        }
+
+        std::array<TileMask, BATCH_LANES> inChain;
+        std::array<TileMask, BATCH_LANES> carry;
+        {
+            TileMask* w0 = m_window[0].data() + base;
+            const TileMask* w1 = m_window[1].data() + base;
+            for (size_t l = 0; l < BATCH_LANES; ++l) {
+                const TileMask hasYou = AnyOf(w0[l], you);
+                const TileMask free1 = TileMask(~AnyOf(w1[l], stop));
+                const TileMask moves = TileMask(hasYou & free1 & ok[l]);
+
+                m_moved[base + l] = uint8_t(moves & 1);
+                m_overflow[base + l] = uint8_t(hasYou & free1 & allPush[l] & 1);
+
+                inChain[l] = moves;
+                carry[l] = TileMask(w0[l] & you & moves);
+                w0[l] = TileMask(w0[l] & ~carry[l]);
+            }
+        }
+
+        for (int k = 1; k < BATCH_WINDOW; ++k) {
+            TileMask* w = m_window[k].data() + base;
+            for (size_t l = 0; l < BATCH_LANES; ++l) {
+                const TileMask pushed = TileMask(w[l] & push & inChain[l]);
+                inChain[l] = TileMask(inChain[l] & AnyOf(w[l], push));
+                w[l] = TileMask((w[l] & ~pushed) | carry[l]);
+                carry[l] = pushed;
+            }
+        }
+    }
+}
+
+void BatchEngine::Scatter(std::span<const Direction> actions, size_t first, size_t last) {
+    for (size_t env = first; env < last; ++env) {
+        if (m_moved[env]) {
+            TileMask* board = Board(env);
+            const auto& ahead = m_ahead[int(actions[env])][m_you[env]];
+            for (int k = 0; k < BATCH_WINDOW; ++k) {
+                board[ahead[k]] = m_window[k][env];
+            }
+            board[NUM_TILES] = EDGE_BIT;
+
+            m_you[env] = ahead[1];
+            m_wins[env] = (m_window[1][env] & m_winMask) != 0;
+        } else if (m_overflow[env]) {
+            StepScalar(env, actions[env]);
+        }
+    }
+}
+
+void BatchEngine::StepScalar(size_t env, Direction dir) {
+    const auto [dx, dy] = ToDelta(dir);
+    auto inBounds = [](int x, int y) {
+        return x >= 0 && x < LEVEL_WIDTH && y >= 0 && y < LEVEL_HEIGHT;
+    };
+
+    TileMask* board = Board(env);
+    const auto [x, y] = ToPos(m_you[env]);
+    const int nx = x + dx;
+    const int ny = y + dy;
+
+    int cx = nx;
+    int cy = ny;
+    while (inBounds(cx, cy) && (board[ToIndex(cx, cy)] & m_pushMask)) {
+        cx += dx;
+        cy += dy;
+    }
+    if (!inBounds(cx, cy) || (board[ToIndex(cx, cy)] & m_stopMask)) {
+        return;
+    }
+
+    while (cx != nx || cy != ny) {
+        const uint16_t from = ToIndex(cx - dx, cy - dy);
+        const TileMask pushed = board[from] & m_pushMask;
+        board[from] &= TileMask(~pushed);
+        board[ToIndex(cx, cy)] |= pushed;
+        cx -= dx;
+        cy -= dy;
+    }
+
+    const uint16_t from = ToIndex(x, y);
+    const uint16_t to = ToIndex(nx, ny);
+    const TileMask moving = board[from] & m_youMask;
+    board[from] &= TileMask(~moving);
+    board[to] |= moving;
+
+    m_you[env] = to;
+    m_wins[env] = (board[to] & m_winMask) != 0;
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "engine.h"
+#include "game_state.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace BabaIsYou {
+
+// Set of object types on a tile, one bit per ObjectType, plus the board edge bit above them
+using TileMask = uint16_t;
+static_assert(NUM_OBJECT_TYPES < 16, "TileMask needs a bit for every type and the edge");
+
+constexpr size_t BATCH_LANES = 16;  // environments resolved together
+constexpr int BATCH_WINDOW = 8;     // the You tile and the tiles ahead of it
+constexpr uint16_t NO_YOU = 0xFFFF; // environment has no You to move
+
+// Steps many independent boards in one call, for agent training.
+//
+// Boards are tile masks, and everything per environment is kept as structure-of-arrays. A step
+// gathers the BATCH_WINDOW tiles from each You along its move into lane buffers, resolves
+// You/Stop/Push for BATCH_LANES environments at a time with branch-free mask arithmetic the
+// compiler vectorizes, and scatters the window back. Push chains longer than the window take a
+// scalar path.
+//
+// Compared to Engine, a board must have at most one You object, and a tile holds a set of types:
+// two objects of the same type on one tile merge. Rules are those of the engine at construction.
+class BatchEngine {
+  public:
+    BatchEngine(const Engine& engine, size_t numEnvs);
+
+    size_t Size() const { return m_numEnvs; }
+
+    // Returns false when the state has more than one You object
+    bool SetState(size_t env, const GameState& gs);
+    void GetState(size_t env, GameState& gs) const;
+    TileMask At(size_t env, int x, int y) const { return Board(env)[ToIndex(x, y)]; }
+
+    // actions.size() == Size()
+    void Step(std::span<const Direction> actions) { Step(actions, 0, m_numEnvs); }
+
+    // Steps environments [first, last) only, so threads can each take a disjoint range. Both
+    // ends must be multiples of BATCH_LANES, except that `last` may be Size().
+    void Step(std::span<const Direction> actions, size_t first, size_t last);
+    std::span<const uint8_t> Wins() const { return { m_wins.data(), m_numEnvs }; }
+
+  private:
+    static constexpr size_t STRIDE = NUM_TILES + 1; // last tile of every board is an edge
+
+    TileMask* Board(size_t env) { return m_boards.data() + env * STRIDE; }
+    const TileMask* Board(size_t env) const { return m_boards.data() + env * STRIDE; }
+
+    void Gather(std::span<const Direction> actions, size_t first, size_t last);
+    void Resolve(size_t first, size_t last);
+    void Scatter(std::span<const Direction> actions, size_t first, size_t last);
+    void StepScalar(size_t env, Direction dir);
+
+    size_t m_numEnvs;
+    size_t m_numPadded; // m_numEnvs rounded up to BATCH_LANES
+
+    TileMask m_youMask = 0;
+    TileMask m_pushMask = 0;
+    TileMask m_stopMask = 0;
+    TileMask m_winMask = 0;
+
+    // m_ahead[dir][tile] lists the window tiles from `tile` in `dir`; off-board tiles are the edge
+    std::array<std::vector<std::array<uint16_t, BATCH_WINDOW>>, 4> m_ahead;
+
+    std::vector<TileMask> m_boards; // STRIDE tiles per environment
+    std::vector<uint16_t> m_you;    // You tile per environment, NO_YOU if none
+    std::vector<uint8_t> m_wins;
+
+    // lane buffers, [window slot][environment]
+    std::array<std::vector<TileMask>, BATCH_WINDOW> m_window;
+    std::vector<uint8_t> m_moved;
+    std::vector<uint8_t> m_overflow; // push chain runs past the window
+};
+
+} // namespace BabaIsYou
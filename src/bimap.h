@@ -1,9 +1,13 @@
+#pragma once
+
 #include <algorithm>
 #include <unordered_map>
 #include <vector>
 
 namespace BabaIsYou {
 
+// Removing the last value of a key keeps its emptied vector, so rules that are toggled on and off
+// reuse their storage instead of reallocating it on every change.
 template <typename A, typename B>
 class BiMap {
   public:
@@ -23,17 +27,11 @@ class BiMap {
         if (auto it = m_AToB.find(a); it != m_AToB.end()) {
             auto& va = it->second;
             va.erase(std::remove(va.begin(), va.end(), b), va.end());
-            if (va.empty()) {
-                m_AToB.erase(it);
-            }
         }
 
         if (auto it = m_BToA.find(b); it != m_BToA.end()) {
             auto& vb = it->second;
             vb.erase(std::remove(vb.begin(), vb.end(), a), vb.end());
-            if (vb.empty()) {
-                m_BToA.erase(it);
-            }
         }
     }
 
@@ -0,0 +1,82 @@
+#include "block_pool.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <new>
+
+namespace BabaIsYou {
+
+namespace {
+
+constexpr size_t NUM_CLASSES = MAX_POOLED_BYTES / POOL_GRANULE;
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct FreeLists {
+    std::array<FreeBlock*, NUM_CLASSES> heads{};
+    std::array<uint32_t, NUM_CLASSES> counts{};
+    size_t limit = MAX_FREE_PER_CLASS;
+
+    ~FreeLists();
+};
+
+// Set once the thread's lists are gone, for blocks freed by later thread_local destructors
+thread_local bool t_listsDestroyed = false;
+
+FreeLists::~FreeLists() {
+    for (FreeBlock* head : heads) {
+        while (head) {
+            FreeBlock* next = head->next;
+            ::operator delete(head);
+            head = next;
+        }
+    }
+    t_listsDestroyed = true;
+}
+
+thread_local FreeLists t_lists;
+
+size_t ClassOf(size_t bytes) {
+    return (bytes + POOL_GRANULE - 1) / POOL_GRANULE - 1;
+}
+
+} // namespace
+
+void* PoolAllocate(size_t bytes) {
+    if (bytes == 0 || bytes > MAX_POOLED_BYTES || t_listsDestroyed) {
+        return ::operator new(bytes);
+    }
+
+    const size_t c = ClassOf(bytes);
+    if (FreeBlock* block = t_lists.heads[c]) {
+        t_lists.heads[c] = block->next;
+        t_lists.counts[c]--;
+        return block;
+    }
+    return ::operator new((c + 1) * POOL_GRANULE);
+}
+
+void PoolFree(void* block, size_t bytes) {
+    if (bytes == 0 || bytes > MAX_POOLED_BYTES || t_listsDestroyed) {
+        ::operator delete(block);
+        return;
+    }
+
+    const size_t c = ClassOf(bytes);
+    if (t_lists.counts[c] >= t_lists.limit) {
+        ::operator delete(block);
+        return;
+    }
+    t_lists.heads[c] = new (block) FreeBlock{ t_lists.heads[c] };
+    t_lists.counts[c]++;
+}
+
+void PoolKeep(size_t blocks) {
+    if (!t_listsDestroyed) {
+        t_lists.limit = std::max(t_lists.limit, blocks);
+    }
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+
+namespace BabaIsYou {
+
+constexpr size_t POOL_GRANULE = 64;             // size classes are multiples of this
+constexpr size_t MAX_POOLED_BYTES = 32 * 1024;  // larger blocks go straight to the heap
+constexpr size_t MAX_FREE_PER_CLASS = 1024;     // free blocks a thread keeps per size class,
+                                                // unless PoolKeep raised it
+
+// Recycles the copy-on-write blocks of game states. They outlive the turn that made them, so
+// they cannot come from an Arena; instead a freed block goes onto its thread's free list for its
+// size class, and the next block of that class reuses it. Once a workload has warmed the lists,
+// it makes and drops blocks without touching the heap.
+//
+// A block may be freed on another thread than the one that allocated it.
+void* PoolAllocate(size_t bytes);
+void PoolFree(void* block, size_t bytes);
+
+// From now on, the calling thread keeps up to `blocks` free blocks per size class, if that is
+// more than it did. A workload whose live set drops and regrows by that many blocks, such as
+// a session's undo history, then never hands them back to the heap.
+void PoolKeep(size_t blocks);
+
+// Standard allocator over the pool, for allocate_shared and containers
+template <typename T>
+struct PoolAllocator {
+    using value_type = T;
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(PoolAllocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { PoolFree(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const {
+        return true;
+    }
+};
+
+} // namespace BabaIsYou
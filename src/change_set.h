@@ -0,0 +1,71 @@
+#pragma once
+
+#include "game_state.h"
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace BabaIsYou {
+
+// One object stepping from one tile to another
+struct ObjectMove {
+    uint16_t from;
+    uint16_t to;
+    ObjectType type;
+    EntityId id;
+};
+
+// Tiles whose contents changed during a turn, each listed once, and the object moves that
+// changed them, in the order they happened. Fixed capacity, never allocates. The tiles always
+// fit; the moves may not, since an object can move more than once a turn when a You is also
+// Push, so moves past capacity are dropped and MovesDropped() tells. Their tiles are still
+// marked.
+class ChangeSet {
+  public:
+    void Add(uint16_t index) {
+        if (!m_marked.test(index)) {
+            m_marked.set(index);
+            m_tiles[m_count++] = index;
+        }
+    }
+
+    // Records the move and marks both tiles
+    void AddMove(uint16_t from, uint16_t to, ObjectType type, EntityId id) {
+        if (m_numMoves < m_moves.size()) {
+            m_moves[m_numMoves++] = { from, to, type, id };
+        } else {
+            m_movesDropped = true;
+        }
+        Add(from);
+        Add(to);
+    }
+
+    void Clear() {
+        for (size_t i = 0; i < m_count; ++i) {
+            m_marked.reset(m_tiles[i]);
+        }
+        m_count = 0;
+        m_numMoves = 0;
+        m_movesDropped = false;
+    }
+
+    bool Contains(uint16_t index) const { return m_marked.test(index); }
+    bool IsEmpty() const { return m_count == 0; }
+    std::span<const uint16_t> Tiles() const { return { m_tiles.data(), m_count }; }
+    std::span<const ObjectMove> Moves() const { return { m_moves.data(), m_numMoves }; }
+    // Moves() is missing some of the turn's moves
+    bool MovesDropped() const { return m_movesDropped; }
+
+  private:
+    std::array<uint16_t, NUM_TILES> m_tiles;
+    size_t m_count = 0;
+    std::bitset<NUM_TILES> m_marked;
+
+    std::array<ObjectMove, MAX_INDEXED_OBJECTS> m_moves;
+    size_t m_numMoves = 0;
+    bool m_movesDropped = false;
+};
+
+} // namespace BabaIsYou
@@ -0,0 +1,524 @@
+// Headless command line front end for batch jobs: no window, no raylib.
+
+#include "alloc_counter.h"
+#include "batch_engine.h"
+#include "engine.h"
+#include "level.h"
+#include "level_analyzer.h"
+#include "level_generator.h"
+#include "replay_minimizer.h"
+#include "session.h"
+#include "solver.h"
+#include "state_graph.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace BabaIsYou;
+
+namespace {
+
+constexpr int EXIT_USAGE = 2;
+constexpr size_t WARMUP_STEPS = 100'000; // untimed, fill the undo history and block pool first
+
+struct Options {
+    std::string pack;
+    size_t maxStates = 0; // 0 for the command's default
+    unsigned threads = 0; // 0 for one per core
+    bool bidirectional = false;
+    std::string externalDir;
+    int radius = MinimizerOptions{}.radius;
+    GeneratorOptions generator;
+    std::vector<std::string> args; // positional, command first
+};
+
+void PrintUsage() {
+    std::puts("usage: BabaCli <command> [args] [options]\n"
+              "\n"
+              "commands:\n"
+              "  levels                    list the levels\n"
+              "  show <level>              print a level\n"
+              "  play <level> <moves>      apply moves (W/A/S/D, X undoes) and print the board\n"
+              "  solve <level>             print a shortest solution\n"
+              "  validate <level> <moves>  exit with 0 if the moves win the level, 1 otherwise\n"
+              "  minimize <level> <moves>  print the shortest win, then the one with fewest\n"
+              "                            pushes, found near a winning replay\n"
+              "  bench <level> [steps]     time random moves, failing if they allocate\n"
+              "  bench-session <level> [turns]\n"
+              "                            time random moves and undos with undo history, failing\n"
+              "                            if they allocate\n"
+              "  bench-batch <level> [envs] [steps]\n"
+              "                            time random moves on a batch of boards, split over the\n"
+              "                            threads\n"
+              "  generate <count>          print a pack of new levels, each checked by the solver\n"
+              "  analyze                   print difficulty metrics of every level as CSV\n"
+              "  export-graph <level> <file>\n"
+              "                            write the reachable state graph as a binary edge list\n"
+              "\n"
+              "options:\n"
+              "  --pack FILE               use the levels of a pack file instead of the built-in ones\n"
+              "  --max-states N            state limit for solve, minimize and export-graph, per\n"
+              "                            candidate for generate, per level for analyze\n"
+              "  --threads N               workers for generate, analyze and bench-batch, default\n"
+              "                            one per core\n"
+              "  --bidirectional           solve meeting a backward search, faster but not always\n"
+              "                            shortest\n"
+              "  --external DIR            solve breadth first with the layers on disk in DIR,\n"
+              "                            with no state limit unless --max-states is given;\n"
+              "                            where export-graph keeps its layers, default\n"
+              "                            <file>.tmp\n"
+              "  --radius N                moves minimize may stray from the replay\n"
+              "  --seed N                  generator seed\n"
+              "  --min-moves N             shortest solution length a generated level may have\n"
+              "  --max-moves N             longest one");
+}
+
+bool ParseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--pack" && i + 1 < argc) {
+            options.pack = argv[++i];
+        } else if (arg == "--max-states" && i + 1 < argc) {
+            options.maxStates = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--bidirectional") {
+            options.bidirectional = true;
+        } else if (arg == "--external" && i + 1 < argc) {
+            options.externalDir = argv[++i];
+        } else if (arg == "--radius" && i + 1 < argc) {
+            options.radius = int(std::strtol(argv[++i], nullptr, 10));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.generator.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--min-moves" && i + 1 < argc) {
+            options.generator.minMoves = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--max-moves" && i + 1 < argc) {
+            options.generator.maxMoves = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg.starts_with("--")) {
+            return false;
+        } else {
+            options.args.push_back(arg);
+        }
+    }
+    return !options.args.empty();
+}
+
+bool ParseLevel(const std::string& arg, const Session& session, int& index) {
+    char* end = nullptr;
+    index = int(std::strtol(arg.c_str(), &end, 10));
+    if (end == arg.c_str() || *end != '\0' || index < 0 || index >= session.GetLevels().Count()) {
+        std::fprintf(stderr, "invalid level '%s', expected 0..%d\n", arg.c_str(),
+            session.GetLevels().Count() - 1);
+        return false;
+    }
+    return true;
+}
+
+void PrintState(const GameState& gs, const LevelManager& levels) {
+    for (int y = 0; y < LEVEL_HEIGHT; ++y) {
+        std::string line;
+        for (int x = 0; x < LEVEL_WIDTH; ++x) {
+            const TileObjects tile = gs.At(x, y);
+            line.push_back(tile.IsEmpty() ? ' ' : levels.ToChar(tile.Top()));
+        }
+        std::puts(line.c_str());
+    }
+}
+
+// Returns false on an unknown move
+bool Play(Session& session, const std::string& moves) {
+    const BatchResult result = session.ApplyMoves(moves);
+    if (!result.valid) {
+        std::fprintf(stderr, "invalid move '%c' at %zu\n", moves[result.applied], result.applied);
+        return false;
+    }
+    return true;
+}
+
+int CmdLevels(const Session& session) {
+    for (int i = 0; i < session.GetLevels().Count(); ++i) {
+        std::printf("%d\n", i);
+    }
+    return EXIT_SUCCESS;
+}
+
+int CmdShow(Session& session) {
+    PrintState(session.GetState(), session.GetLevels());
+    return EXIT_SUCCESS;
+}
+
+int CmdPlay(Session& session, const std::string& moves) {
+    if (!Play(session, moves)) {
+        return EXIT_USAGE;
+    }
+    PrintState(session.GetState(), session.GetLevels());
+    std::printf("win: %s\n", session.GetState().IsWin() ? "yes" : "no");
+    return EXIT_SUCCESS;
+}
+
+int CmdValidate(Session& session, const std::string& moves) {
+    if (!Play(session, moves)) {
+        return EXIT_USAGE;
+    }
+    const bool win = session.GetState().IsWin();
+    std::puts(win ? "valid" : "invalid");
+    return win ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int CmdMinimize(Session& session, const std::string& replay, const Options& cli) {
+    // played through the session, so that undo behaves exactly as in play and validate
+    const GameState initial = session.GetState();
+    std::vector<GameState> played;
+    BatchOptions batch;
+    batch.onState = [&played](const GameState& gs) { played.push_back(gs); };
+    const BatchResult replayed = session.ApplyMoves(replay, batch);
+    if (!replayed.valid) {
+        std::fprintf(stderr, "invalid move '%c' at %zu\n", replay[replayed.applied],
+            replayed.applied);
+        return EXIT_USAGE;
+    }
+
+    MinimizerOptions options;
+    options.radius = cli.radius;
+    if (cli.maxStates != 0) {
+        options.maxStates = cli.maxStates;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const MinimizedReplay result =
+        ReplayMinimizer(session.GetEngine()).Minimize(initial, played, options);
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!result.won) {
+        std::puts("replay does not win");
+        return EXIT_FAILURE;
+    }
+    const Engine& engine = session.GetEngine();
+    std::printf("%s\n%s\n", result.shortest.c_str(), result.fewestPushes.c_str());
+    std::fprintf(stderr,
+        "shortest: %zu moves, %zu pushes; fewest pushes: %zu moves, %zu pushes; states: %zu, "
+        "time: %.3f s\n",
+        result.shortest.size(), CountPushes(engine, initial, result.shortest),
+        result.fewestPushes.size(), CountPushes(engine, initial, result.fewestPushes),
+        result.statesVisited, seconds);
+    return EXIT_SUCCESS;
+}
+
+int CmdExportGraph(const Session& session, const std::string& path, const Options& cli) {
+    GraphExportOptions options;
+    options.tempDir = cli.externalDir;
+    if (cli.maxStates != 0) {
+        options.maxStates = cli.maxStates;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const GraphExportResult result =
+        StateGraphExporter(session.GetEngine()).Export(session.GetState(), path, options);
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!result.ok) {
+        std::fprintf(stderr, "could not write '%s' or its layers\n", path.c_str());
+        return EXIT_FAILURE;
+    }
+    std::fprintf(stderr, "states: %zu, edges: %zu, wins: %zu, complete: %s, time: %.3f s\n",
+        result.states, result.edges, result.wins, result.complete ? "yes" : "no", seconds);
+    return EXIT_SUCCESS;
+}
+
+int CmdSolve(const Session& session, const Options& cli) {
+    SolverOptions options;
+    options.bidirectional = cli.bidirectional;
+    options.externalDir = cli.externalDir;
+    if (!cli.externalDir.empty() && !cli.bidirectional) {
+        options.maxStates = SIZE_MAX; // bounded by the disk instead
+    }
+    if (cli.maxStates != 0) {
+        options.maxStates = cli.maxStates;
+    }
+    const size_t allocations = AllocationCount();
+    const auto start = std::chrono::steady_clock::now();
+    const SolverResult result = Solver(session.GetEngine()).Solve(session.GetState(), options);
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (result.failed) {
+        std::fprintf(stderr, "search failed: could not use '%s'\n", cli.externalDir.c_str());
+        return EXIT_FAILURE;
+    }
+    if (result.solved) {
+        std::printf("%s\n", result.moves.c_str());
+    } else {
+        std::puts(result.exhausted ? "unsolvable" : "gave up");
+    }
+    std::fprintf(stderr, "moves: %zu, states: %zu, time: %.3f s, allocations: %zu\n",
+        result.moves.size(), result.statesVisited, seconds, AllocationCount() - allocations);
+    return result.solved ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int CmdBench(const Session& session, size_t steps) {
+    const Engine& engine = session.GetEngine();
+    const GameState& start = session.GetState();
+
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> pick(0, int(DIRECTIONS.size()) - 1);
+
+    GameState state = start;
+    size_t wins = 0;
+    auto step = [&] {
+        engine.Step(state, DIRECTIONS[pick(rng)]);
+        if (state.IsWin()) {
+            state = start;
+            wins++;
+        }
+    };
+    for (size_t i = 0; i < WARMUP_STEPS; ++i) {
+        step();
+    }
+
+    wins = 0;
+    const size_t allocations = AllocationCount();
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < steps; ++i) {
+        step();
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    const size_t allocated = AllocationCount() - allocations;
+    std::printf("steps: %zu, wins: %zu, time: %.3f s, %.0f steps/s, allocations: %zu\n", steps,
+        wins, seconds, steps / seconds, allocated);
+    return allocated == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Like the game: every move goes through the session and its undo history
+int CmdBenchSession(Session& session, size_t turns) {
+    std::mt19937 rng(12345);
+    size_t wins = 0;
+    auto turn = [&] {
+        if (rng() % 8 == 0) {
+            session.Undo();
+        } else {
+            session.TryMove(DIRECTIONS[rng() % DIRECTIONS.size()]);
+        }
+        if (session.GetState().IsWin()) {
+            session.LoadLevel();
+            wins++;
+        }
+    };
+    for (size_t i = 0; i < WARMUP_STEPS; ++i) {
+        turn();
+    }
+
+    wins = 0;
+    const size_t allocations = AllocationCount();
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < turns; ++i) {
+        turn();
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    const size_t allocated = AllocationCount() - allocations;
+    std::printf("turns: %zu, wins: %zu, time: %.3f s, %.0f turns/s, allocations: %zu\n", turns,
+        wins, seconds, turns / seconds, allocated);
+    return allocated == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Each worker steps its own range of the boards, as many lane groups as the others give or take
+// one; the boards are independent, so the workers never wait for each other
+int CmdBenchBatch(const Session& session, size_t numEnvs, size_t steps, unsigned threads) {
+    const GameState& start = session.GetState();
+    BatchEngine batch(session.GetEngine(), numEnvs);
+    for (size_t env = 0; env < numEnvs; ++env) {
+        if (!batch.SetState(env, start)) {
+            std::fputs("batch boards need at most one You object\n", stderr);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // random actions drawn up front so the timing is the stepper's alone
+    std::mt19937 rng(12345);
+    std::vector<Direction> actions(numEnvs + 4096);
+    for (auto& action : actions) {
+        action = DIRECTIONS[rng() % DIRECTIONS.size()];
+    }
+
+    const size_t numGroups = (numEnvs + BATCH_LANES - 1) / BATCH_LANES;
+    const unsigned numThreads = unsigned(std::min<size_t>(
+        threads ? threads : std::max(1u, std::thread::hardware_concurrency()),
+        std::max<size_t>(numGroups, 1)));
+    std::vector<size_t> wins(numThreads, 0);
+    auto work = [&](unsigned worker) {
+        const size_t first = numGroups * worker / numThreads * BATCH_LANES;
+        const size_t last = std::min(numGroups * (worker + 1) / numThreads * BATCH_LANES, numEnvs);
+        std::mt19937 offsets(12345 + worker);
+        for (size_t i = 0; i < steps; ++i) {
+            batch.Step({ actions.data() + offsets() % 4096, numEnvs }, first, last);
+            const auto won = batch.Wins();
+            for (size_t env = first; env < last; ++env) {
+                if (won[env]) {
+                    batch.SetState(env, start);
+                    wins[worker]++;
+                }
+            }
+        }
+    };
+
+    const auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < numThreads; ++i) {
+        workers.emplace_back(work, i);
+    }
+    work(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    size_t totalWins = 0;
+    for (const size_t w : wins) {
+        totalWins += w;
+    }
+    const double envSteps = double(steps) * numEnvs;
+    std::printf("envs: %zu, threads: %u, steps: %zu, wins: %zu, time: %.3f s, %.0f env steps/s\n",
+        numEnvs, numThreads, steps, totalWins, seconds, envSteps / seconds);
+    return EXIT_SUCCESS;
+}
+
+// Writes the levels as a pack that --pack loads back, each after a comment with its stats
+int CmdGenerate(const Session& session, size_t count, const Options& cli) {
+    GeneratorOptions options = cli.generator;
+    options.threads = cli.threads;
+    if (cli.maxStates != 0) {
+        options.maxStates = cli.maxStates;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const GeneratorResult result =
+        LevelGenerator(session.GetEngine(), session.GetLevels()).Generate(count, options);
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const auto& generated : result.levels) {
+        std::printf("; candidate %llu, moves %zu, pushes %zu, states %zu\n",
+            (unsigned long long)generated.candidate, generated.solution.size(), generated.pushes,
+            generated.statesVisited);
+        for (const auto& row : generated.level) {
+            std::string line(row.data());
+            line.erase(line.find_last_not_of(' ') + 1);
+            std::puts(line.c_str());
+        }
+        std::puts("");
+    }
+    std::fprintf(stderr, "levels: %zu, candidates: %zu, time: %.3f s\n", result.levels.size(),
+        result.candidates, seconds);
+    return result.levels.size() == count ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// One CSV row per level; the deadlock count is left empty when the space was too large to
+// explore whole, and the solution columns when no win was found
+int CmdAnalyze(const Session& session, const Options& cli) {
+    AnalyzerOptions options;
+    options.threads = cli.threads;
+    if (cli.maxStates != 0) {
+        options.maxStates = cli.maxStates;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<LevelMetrics> metrics =
+        LevelAnalyzer(session.GetEngine()).AnalyzeAll(session.GetLevels(), options);
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::puts("level,solvable,optimal_moves,pushes,states,complete,branching,deadlocks");
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        const LevelMetrics& m = metrics[i];
+        std::string solution = ",";
+        if (m.solvable) {
+            solution = std::to_string(m.optimalMoves) + "," + std::to_string(m.pushes);
+        }
+        const std::string deadlocks = m.complete ? std::to_string(m.deadlocks) : "";
+        std::printf("%zu,%d,%s,%zu,%d,%.3f,%s\n", i, m.solvable, solution.c_str(), m.states,
+            m.complete, m.branching, deadlocks.c_str());
+    }
+    std::fprintf(stderr, "levels: %zu, time: %.3f s\n", metrics.size(), seconds);
+    return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseArgs(argc, argv, options)) {
+        PrintUsage();
+        return EXIT_USAGE;
+    }
+
+    auto session = std::make_unique<Session>();
+    if (!options.pack.empty()) {
+        std::ifstream file(options.pack);
+        if (!file || !session->GetLevels().LoadPack(file)) {
+            std::fprintf(stderr, "could not load level pack '%s'\n", options.pack.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    const auto& args = options.args;
+    const std::string& command = args[0];
+    if (command == "levels") {
+        return CmdLevels(*session);
+    } else if (command == "generate" && args.size() == 2) {
+        return CmdGenerate(*session, std::strtoull(args[1].c_str(), nullptr, 10), options);
+    } else if (command == "analyze") {
+        return CmdAnalyze(*session, options);
+    }
+
+    const size_t needed =
+        (command == "play" || command == "validate" || command == "minimize" ||
+            command == "export-graph")
+        ? 3
+        : 2;
+    int level = 0;
+    if (args.size() < needed || !ParseLevel(args[1], *session, level)) {
+        PrintUsage();
+        return EXIT_USAGE;
+    }
+    session->SelectLevel(level);
+
+    if (command == "show") {
+        return CmdShow(*session);
+    } else if (command == "play") {
+        return CmdPlay(*session, args[2]);
+    } else if (command == "validate") {
+        return CmdValidate(*session, args[2]);
+    } else if (command == "minimize") {
+        return CmdMinimize(*session, args[2], options);
+    } else if (command == "export-graph") {
+        return CmdExportGraph(*session, args[2], options);
+    } else if (command == "solve") {
+        return CmdSolve(*session, options);
+    } else if (command == "bench") {
+        return CmdBench(*session, args.size() > 2 ? std::strtoull(args[2].c_str(), nullptr, 10)
+                                                  : 1'000'000);
+    } else if (command == "bench-session") {
+        const size_t turns = args.size() > 2 ? std::strtoull(args[2].c_str(), nullptr, 10)
+                                             : 1'000'000;
+        return CmdBenchSession(*session, turns);
+    } else if (command == "bench-batch") {
+        const size_t numEnvs = args.size() > 2 ? std::strtoull(args[2].c_str(), nullptr, 10) : 4096;
+        const size_t steps = args.size() > 3 ? std::strtoull(args[3].c_str(), nullptr, 10) : 1000;
+        return CmdBenchBatch(*session, numEnvs, steps, options.threads);
+    }
+
+    PrintUsage();
+    return EXIT_USAGE;
+}
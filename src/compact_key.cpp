@@ -0,0 +1,179 @@
+#include "compact_key.h"
+#include <algorithm>
+#include <array>
+
+namespace BabaIsYou {
+
+namespace {
+
+constexpr int NUM_RULE_PROPERTIES = 4;
+constexpr int RULE_BITS = NUM_RULE_PROPERTIES * NUM_OBJECT_TYPES;
+constexpr int POSITION_BITS = 10;
+static_assert(RULE_BITS <= 64, "the rule set must fit one word");
+static_assert(NUM_TILES <= (1 << POSITION_BITS), "a tile index must fit POSITION_BITS");
+
+// Writes fields of up to 64 bits back to back, low bits first; a field may straddle two words
+class BitWriter {
+  public:
+    explicit BitWriter(std::span<uint64_t> words) : m_words(words) {
+        std::fill(words.begin(), words.end(), 0);
+    }
+
+    void Put(uint64_t value, int bits) {
+        const size_t word = m_pos / 64;
+        const int shift = int(m_pos % 64);
+        m_words[word] |= value << shift;
+        if (shift + bits > 64) {
+            m_words[word + 1] |= value >> (64 - shift);
+        }
+        m_pos += size_t(bits);
+    }
+
+  private:
+    std::span<uint64_t> m_words;
+    size_t m_pos = 0;
+};
+
+class BitReader {
+  public:
+    explicit BitReader(std::span<const uint64_t> words) : m_words(words) {}
+
+    uint64_t Get(int bits) {
+        const size_t word = m_pos / 64;
+        const int shift = int(m_pos % 64);
+        uint64_t value = m_words[word] >> shift;
+        if (shift + bits > 64) {
+            value |= m_words[word + 1] << (64 - shift);
+        }
+        m_pos += size_t(bits);
+        return bits == 64 ? value : value & ((uint64_t(1) << bits) - 1);
+    }
+
+  private:
+    std::span<const uint64_t> m_words;
+    size_t m_pos = 0;
+};
+
+} // namespace
+
+CompactKeyCodec::CompactKeyCodec(const Engine& engine, const GameState& start) : m_static(start) {
+    const auto& rules = engine.GetRules();
+    for (int property = 0; property < NUM_RULE_PROPERTIES; ++property) {
+        for (const auto type : rules.Get(Property(property))) {
+            m_rules |= uint64_t(1) << (property * NUM_OBJECT_TYPES + int(type));
+        }
+    }
+
+    const auto& you = rules.Get(Property::You);
+    const auto& push = rules.Get(Property::Push);
+    size_t bits = RULE_BITS;
+    for (ObjectType type = ObjectType::Empty; type < ObjectType::NumType; ++type) {
+        const bool movable = std::find(you.begin(), you.end(), type) != you.end() ||
+            std::find(push.begin(), push.end(), type) != push.end();
+        if (!movable || start.Count(type) == 0) {
+            continue;
+        }
+        m_movable.push_back(type);
+        m_counts.push_back(start.Count(type));
+        bits += start.Count(type) * POSITION_BITS;
+
+        // a copy, since removing objects changes the index being read
+        const std::vector<uint16_t> positions(start.Positions(type).begin(),
+            start.Positions(type).end());
+        for (const auto index : positions) {
+            const auto [x, y] = ToPos(index);
+            m_static.Remove(x, y, type);
+        }
+    }
+    m_static.SetWin(false);
+    m_words = (bits + 63) / 64;
+}
+
+void CompactKeyCodec::Encode(const GameState& gs, std::span<uint64_t> key) const {
+    BitWriter writer(key);
+    writer.Put(m_rules, RULE_BITS);
+
+    std::array<uint16_t, MAX_INDEXED_OBJECTS> sorted;
+    for (const auto type : m_movable) {
+        const auto positions = gs.Positions(type);
+        std::copy(positions.begin(), positions.end(), sorted.begin());
+        std::sort(sorted.begin(), sorted.begin() + positions.size());
+        for (size_t i = 0; i < positions.size(); ++i) {
+            writer.Put(sorted[i], POSITION_BITS);
+        }
+    }
+}
+
+void CompactKeyCodec::Decode(std::span<const uint64_t> key, GameState& gs) const {
+    BitReader reader(key);
+    reader.Get(RULE_BITS);
+
+    gs = m_static;
+    for (size_t t = 0; t < m_movable.size(); ++t) {
+        for (size_t i = 0; i < m_counts[t]; ++i) {
+            const auto [x, y] = ToPos(uint16_t(reader.Get(POSITION_BITS)));
+            gs.Push(x, y, m_movable[t]);
+        }
+    }
+}
+
+uint64_t HashCompactKey(std::span<const uint64_t> key) {
+    // splitmix64 finalizer over each word in turn
+    uint64_t hash = 0x9e3779b97f4a7c15ull;
+    for (const uint64_t word : key) {
+        hash ^= word;
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+        hash ^= hash >> 31;
+    }
+    return hash;
+}
+
+std::pair<int32_t, bool> CompactKeySet::Insert(std::span<const uint64_t> key) {
+    if ((m_size + 1) * 2 > m_table.size()) {
+        Grow();
+    }
+    const size_t mask = m_table.size() - 1;
+    for (size_t slot = HashCompactKey(key) & mask;; slot = (slot + 1) & mask) {
+        if (m_table[slot] == EMPTY) {
+            const int32_t index = int32_t(m_size++);
+            m_table[slot] = index;
+            m_keys.insert(m_keys.end(), key.begin(), key.end());
+            return { index, true };
+        }
+        if (Equal(m_table[slot], key)) {
+            return { m_table[slot], false };
+        }
+    }
+}
+
+int32_t CompactKeySet::Find(std::span<const uint64_t> key) const {
+    if (m_table.empty()) {
+        return EMPTY;
+    }
+    const size_t mask = m_table.size() - 1;
+    for (size_t slot = HashCompactKey(key) & mask;; slot = (slot + 1) & mask) {
+        if (m_table[slot] == EMPTY || Equal(m_table[slot], key)) {
+            return m_table[slot];
+        }
+    }
+}
+
+bool CompactKeySet::Equal(int32_t index, std::span<const uint64_t> key) const {
+    const auto stored = Key(index);
+    return std::equal(stored.begin(), stored.end(), key.begin());
+}
+
+void CompactKeySet::Grow() {
+    m_table.assign(std::max<size_t>(64, m_table.size() * 2), EMPTY);
+    const size_t mask = m_table.size() - 1;
+    for (size_t index = 0; index < m_size; ++index) {
+        size_t slot = HashCompactKey(Key(int32_t(index))) & mask;
+        while (m_table[slot] != EMPTY) {
+            slot = (slot + 1) & mask;
+        }
+        m_table[slot] = int32_t(index);
+    }
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "engine.h"
+#include "game_state.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace BabaIsYou {
+
+// Search key of a state that holds only what a move can change. Under fixed rules only You and
+// Push objects ever move, and no object is created or destroyed, so walls, floor and other static
+// objects are the same in every state reachable from a start. A key is the rule set, as a bit per
+// type and property, followed by the tile index of each movable object, per type in type order
+// and sorted within a type, packed back to back into 64-bit words. Two states reachable from the
+// same start are equal iff their keys are; the rules never look at stacking order, so neither
+// does the key.
+//
+// Keys take Words() words, a few for most levels, against a byte or more per tile for a key of
+// every tile. The codec is built from a start state; keys of states not reachable from it mean
+// nothing.
+class CompactKeyCodec {
+  public:
+    CompactKeyCodec(const Engine& engine, const GameState& start);
+
+    size_t Words() const { return m_words; }
+
+    // `key` holds Words() words
+    void Encode(const GameState& gs, std::span<uint64_t> key) const;
+    // Rebuilds the state from the start's static objects; the win flag is left cleared
+    void Decode(std::span<const uint64_t> key, GameState& gs) const;
+
+  private:
+    std::vector<ObjectType> m_movable; // in type order
+    std::vector<size_t> m_counts;      // objects per movable type
+    uint64_t m_rules = 0;
+    size_t m_words = 0;
+    GameState m_static; // the start without its movable objects
+};
+
+// 64-bit hash of a compact key
+uint64_t HashCompactKey(std::span<const uint64_t> key);
+
+// Compact keys of one codec, numbered from 0 in insertion order and stored back to back, with an
+// open-addressed table of key numbers to find them. A key costs its words and 8 to 16 bytes of
+// table.
+class CompactKeySet {
+  public:
+    explicit CompactKeySet(size_t words) : m_words(words) {}
+
+    // Returns the key's number and true if it was new
+    std::pair<int32_t, bool> Insert(std::span<const uint64_t> key);
+    // -1 when absent
+    int32_t Find(std::span<const uint64_t> key) const;
+
+    std::span<const uint64_t> Key(int32_t index) const {
+        return { m_keys.data() + size_t(index) * m_words, m_words };
+    }
+    size_t Size() const { return m_size; }
+
+  private:
+    static constexpr int32_t EMPTY = -1;
+
+    bool Equal(int32_t index, std::span<const uint64_t> key) const;
+    void Grow();
+
+    size_t m_words;
+    size_t m_size = 0;
+    std::vector<uint64_t> m_keys;
+    std::vector<int32_t> m_table; // power of two entries, at most half full
+};
+
+} // namespace BabaIsYou
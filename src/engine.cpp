@@ -0,0 +1,166 @@
+#include "engine.h"
+#include "arena.h"
+#include "trace.h"
+#include <algorithm>
+
+namespace BabaIsYou {
+
+Engine::Engine() {
+    m_rules.Add(ObjectType::Baba, Property::You);
+    m_rules.Add(ObjectType::Wall, Property::Stop);
+    m_rules.Add(ObjectType::Flag, Property::Win);
+    m_rules.Add(ObjectType::Rock, Property::Push);
+
+    for (ObjectType i = ObjectType::TextBaba; i < ObjectType::NumType; ++i) {
+        m_rules.Add(i, Property::Push);
+    }
+}
+
+bool Engine::InBounds(int x, int y) {
+    return x >= 0 && x < LEVEL_WIDTH && y >= 0 && y < LEVEL_HEIGHT;
+}
+
+bool Engine::VecContains(const std::vector<ObjectType>& v, ObjectType type) {
+    return std::find(v.begin(), v.end(), type) != v.end();
+}
+
+bool Engine::AllPushable(
+    const TileObjects& tile, const std::vector<ObjectType>& pushObjects) const {
+    for (const auto obj : tile) {
+        if (VecContains(pushObjects, obj)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Engine::HasYou(const GameState& gs) const {
+    for (const auto type : m_rules.Get(Property::You)) {
+        if (gs.Count(type) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Engine::CheckWin(const GameState& gs) const {
+    const auto& winObjects = m_rules.Get(Property::Win);
+    for (const auto type : m_rules.Get(Property::You)) {
+        for (const auto index : gs.Positions(type)) {
+            const auto [x, y] = ToPos(index);
+            if (gs.At(x, y).Contains(winObjects)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Engine::CheckWin(const GameState& gs, const ChangeSet& changes) const {
+    const auto& youObjects = m_rules.Get(Property::You);
+    const auto& winObjects = m_rules.Get(Property::Win);
+    for (const auto index : changes.Tiles()) {
+        const auto [x, y] = ToPos(index);
+        if (gs.At(x, y).Contains(youObjects) && gs.At(x, y).Contains(winObjects)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Engine::Step(GameState& gs, Direction dir, ChangeSet* changes) const {
+    TRACE_ZONE("Engine::Step");
+
+    const auto [dx, dy] = ToDelta(dir);
+    const auto& youObjects = m_rules.Get(Property::You);
+    const auto& pushObjects = m_rules.Get(Property::Push);
+    const auto& stopObjects = m_rules.Get(Property::Stop);
+
+    size_t numYous = 0;
+    for (const auto type : youObjects) {
+        numYous += gs.Count(type);
+    }
+    if (numYous == 0) {
+        return false;
+    }
+
+    // the You list is turn scratch, released when the step returns
+    Arena::Scope scratch(TurnArena());
+    const std::span<YouEntry> yous = scratch.Allocate<YouEntry>(numYous);
+    {
+        TRACE_DETAIL_ZONE("TryMove/YouScan");
+        size_t i = 0;
+        for (const auto type : youObjects) {
+            for (const auto index : gs.Positions(type)) {
+                yous[i++] = { ToPos(index), type };
+            }
+        }
+    }
+
+    {
+        TRACE_DETAIL_ZONE("TryMove/Sort");
+        auto proj = [dx, dy](const Vec2i& pos) { return pos.x * dx + pos.y * dy; };
+        std::sort(yous.begin(), yous.end(),
+            [&proj](const auto& a, const auto& b) { return proj(a.pos) > proj(b.pos); });
+    }
+
+    for (const auto& [pos, type] : yous) {
+        TRACE_DETAIL_ZONE("TryMove/PushChain");
+
+        const int nx = pos.x + dx;
+        const int ny = pos.y + dy;
+
+        if (!InBounds(nx, ny) || gs.At(nx, ny).Contains(stopObjects)) {
+            continue;
+        }
+
+        int cx = nx;
+        int cy = ny;
+
+        while (InBounds(cx, cy) && !gs.At(cx, cy).IsEmpty() &&
+            AllPushable(gs.At(cx, cy), pushObjects)) {
+            cx += dx;
+            cy += dy;
+        }
+
+        if (!InBounds(cx, cy) || gs.At(cx, cy).Contains(stopObjects)) {
+            continue;
+        }
+
+        // perform shift
+        while (cx != nx || cy != ny) {
+            const int prevX = cx - dx;
+            const int prevY = cy - dy;
+
+            std::array<ObjectType, MAX_STACK_HEIGHT> pushed;
+            int numPushed = 0;
+            for (const auto obj : gs.At(prevX, prevY)) {
+                if (VecContains(pushObjects, obj)) {
+                    pushed[numPushed++] = obj;
+                }
+            }
+            for (int i = 0; i < numPushed; ++i) {
+                const EntityId id = gs.Move(prevX, prevY, cx, cy, pushed[i]);
+                if (id != NO_ENTITY && changes) {
+                    changes->AddMove(ToIndex(prevX, prevY), ToIndex(cx, cy), pushed[i], id);
+                }
+            }
+
+            cx = prevX;
+            cy = prevY;
+        }
+
+        // move the You object
+        if (const EntityId id = gs.Move(pos.x, pos.y, nx, ny, type); id != NO_ENTITY && changes) {
+            changes->AddMove(ToIndex(pos.x, pos.y), ToIndex(nx, ny), type, id);
+        }
+    }
+
+    // Without a win before the move, only a tile the move changed can hold one now. Untracked
+    // moves check every You instead, which costs no more than building the change set would.
+    TRACE_DETAIL_ZONE("TryMove/WinCheck");
+    gs.SetWin(gs.IsWin() || !changes ? CheckWin(gs) : CheckWin(gs, *changes));
+    return true;
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "bimap.h"
+#include "change_set.h"
+#include "level.h"
+#include "tile.h"
+#include <span>
+#include <vector>
+
+namespace BabaIsYou {
+
+enum class Direction { Up, Down, Left, Right };
+constexpr std::array<Direction, 4> DIRECTIONS = { Direction::Up, Direction::Down, Direction::Left,
+    Direction::Right };
+
+constexpr Vec2i ToDelta(Direction dir) {
+    switch (dir) {
+        case Direction::Up: return { 0, -1 };
+        case Direction::Down: return { 0, 1 };
+        case Direction::Left: return { -1, 0 };
+        case Direction::Right: return { 1, 0 };
+    }
+    return { 0, 0 };
+}
+
+// Moves are written with the keys that play them: W, A, S, D
+constexpr char ToChar(Direction dir) {
+    constexpr char chars[] = { 'W', 'S', 'A', 'D' };
+    return chars[int(dir)];
+}
+
+constexpr bool FromChar(char c, Direction& dir) {
+    switch (c) {
+        case 'W': case 'w': dir = Direction::Up; return true;
+        case 'S': case 's': dir = Direction::Down; return true;
+        case 'A': case 'a': dir = Direction::Left; return true;
+        case 'D': case 'd': dir = Direction::Right; return true;
+        default: return false;
+    }
+}
+
+// Turn logic. The engine only holds the rules, so one instance can step any number of states.
+class Engine {
+  public:
+    Engine();
+
+    // Moves every You object one tile in `dir`, pushing what is in the way, and updates the win
+    // flag. Returns false, leaving the state untouched, when there is nothing to move. The tiles
+    // the move changed, and the objects it moved, are added to `changes` when given; without it
+    // nothing is tracked.
+    //
+    // The win flag is only re-checked on changed tiles, so `gs` must come in with a flag that is
+    // up to date for the current rules; refresh it with CheckWin after a rule change.
+    bool Step(GameState& gs, Direction dir, ChangeSet* changes = nullptr) const;
+    bool HasYou(const GameState& gs) const;
+    bool CheckWin(const GameState& gs) const;
+
+    void AddRule(ObjectType type, Property property) { m_rules.Add(type, property); }
+    void RemoveRule(ObjectType type, Property property) { m_rules.Remove(type, property); }
+    const BiMap<ObjectType, Property>& GetRules() const { return m_rules; }
+
+  private:
+    struct YouEntry {
+        Vec2i pos;
+        ObjectType type;
+    };
+
+    static bool InBounds(int x, int y);
+    static bool VecContains(const std::vector<ObjectType>& v, ObjectType type);
+    bool AllPushable(const TileObjects& tile, const std::vector<ObjectType>& pushObjects) const;
+    bool CheckWin(const GameState& gs, const ChangeSet& changes) const;
+
+    BiMap<ObjectType, Property> m_rules;
+};
+
+} // namespace BabaIsYou
@@ -0,0 +1,34 @@
+#include "entity_pool.h"
+#include <cassert>
+
+namespace BabaIsYou {
+
+uint16_t EntityPool::Create(ObjectType type) {
+    assert(type != ObjectType::Empty);
+
+    uint16_t slot = m_freeHead;
+    if (slot != NO_SLOT) {
+        m_freeHead = m_slots[slot].nextFree;
+    } else if (m_slots.size() < MAX_ENTITIES) {
+        slot = uint16_t(m_slots.size());
+        m_slots.push_back({ 0, NO_SLOT, type });
+    } else {
+        return NO_SLOT;
+    }
+
+    m_slots[slot].type = type;
+    m_live++;
+    return slot;
+}
+
+void EntityPool::Destroy(uint16_t slot) {
+    assert(slot < m_slots.size() && m_slots[slot].type != ObjectType::Empty);
+
+    m_slots[slot].generation++;
+    m_slots[slot].type = ObjectType::Empty;
+    m_slots[slot].nextFree = m_freeHead;
+    m_freeHead = slot;
+    m_live--;
+}
+
+} // namespace BabaIsYou
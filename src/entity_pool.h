@@ -0,0 +1,58 @@
+#pragma once
+
+#include "block_pool.h"
+#include "tile.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace BabaIsYou {
+
+constexpr size_t MAX_ENTITIES = 4096;
+constexpr uint16_t NO_SLOT = 0xFFFF;
+
+// Handle to one object on a board. The generation tells a handle to a destroyed object apart
+// from one to the object that took over its slot.
+struct EntityId {
+    uint16_t slot;
+    uint16_t generation;
+
+    bool operator==(const EntityId&) const = default;
+};
+
+constexpr EntityId NO_ENTITY = { NO_SLOT, 0 };
+
+// Generational slot map of the objects on a board. Lookups are an array access. Destroying an
+// object frees its slot for the next one created, so the pool only grows, and allocates, when a
+// board holds more objects than it ever has; slots are sized to that high-water mark, which
+// keeps copies small.
+class EntityPool {
+  public:
+    // NO_SLOT when all MAX_ENTITIES slots are live
+    uint16_t Create(ObjectType type);
+    void Destroy(uint16_t slot);
+
+    EntityId Handle(uint16_t slot) const { return { slot, m_slots[slot].generation }; }
+    bool IsAlive(EntityId id) const {
+        return id.slot < m_slots.size() && m_slots[id.slot].generation == id.generation &&
+            m_slots[id.slot].type != ObjectType::Empty;
+    }
+    // Empty for a handle that is not alive
+    ObjectType Type(EntityId id) const {
+        return IsAlive(id) ? m_slots[id.slot].type : ObjectType::Empty;
+    }
+    size_t Size() const { return m_live; }
+
+  private:
+    struct Slot {
+        uint16_t generation;
+        uint16_t nextFree;
+        ObjectType type; // Empty while free
+    };
+
+    std::vector<Slot, PoolAllocator<Slot>> m_slots;
+    uint16_t m_freeHead = NO_SLOT;
+    uint16_t m_live = 0;
+};
+
+} // namespace BabaIsYou
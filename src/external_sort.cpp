@@ -0,0 +1,254 @@
+#include "external_sort.h"
+#include "trace.h"
+#include <algorithm>
+#include <memory>
+#include <queue>
+#include <system_error>
+
+namespace BabaIsYou {
+
+namespace {
+
+constexpr size_t IO_BUFFER = size_t(1) << 20;
+constexpr size_t RECORD_OVERHEAD = 48; // in-memory bytes per buffered record besides its key
+constexpr size_t MAX_FAN_IN = 64;      // runs merged at once
+
+// Streams the records of sorted runs in order, only the first of each state
+class RunMerger {
+  public:
+    explicit RunMerger(std::span<const std::filesystem::path> runs) : m_heads(runs.size()) {
+        for (size_t i = 0; i < runs.size(); ++i) {
+            m_readers.push_back(std::make_unique<RunReader>(runs[i]));
+            m_ok = m_ok && m_readers[i]->Ok();
+            if (m_readers[i]->Read(m_heads[i])) {
+                m_open.push(i);
+            }
+        }
+    }
+
+    bool Ok() const { return m_ok; }
+
+    // Returns false once every run is used up
+    bool Next(StateRecord& record) {
+        while (!m_open.empty()) {
+            const size_t run = m_open.top();
+            m_open.pop();
+            const bool repeated = m_hasLast && SameState(m_heads[run], record);
+            if (!repeated) {
+                record = m_heads[run];
+                m_hasLast = true;
+            }
+            if (m_readers[run]->Read(m_heads[run])) {
+                m_open.push(run);
+            }
+            if (!repeated) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    // orders runs by their head record, smallest on top
+    struct HeadGreater {
+        const std::vector<StateRecord>* heads;
+        bool operator()(size_t a, size_t b) const { return (*heads)[b] < (*heads)[a]; }
+    };
+
+    std::vector<std::unique_ptr<RunReader>> m_readers;
+    std::vector<StateRecord> m_heads;
+    std::priority_queue<size_t, std::vector<size_t>, HeadGreater> m_open{ HeadGreater{
+        &m_heads } };
+    bool m_ok = true;
+    bool m_hasLast = false;
+};
+
+} // namespace
+
+bool operator<(const StateRecord& a, const StateRecord& b) {
+    if (a.hash != b.hash) {
+        return a.hash < b.hash;
+    }
+    return a.key < b.key;
+}
+
+bool SameState(const StateRecord& a, const StateRecord& b) {
+    return a.hash == b.hash && a.key == b.key;
+}
+
+RunWriter::RunWriter(const std::filesystem::path& path) : m_buffer(IO_BUFFER) {
+    m_file.rdbuf()->pubsetbuf(m_buffer.data(), std::streamsize(m_buffer.size()));
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+}
+
+void RunWriter::Write(const StateRecord& record) {
+    const uint8_t move = uint8_t(record.move);
+    const uint16_t length = uint16_t(record.key.size());
+    Put(&record.hash, sizeof(record.hash));
+    Put(&record.parent, sizeof(record.parent));
+    Put(&move, sizeof(move));
+    Put(&length, sizeof(length));
+    Put(record.key.data(), record.key.size() * sizeof(uint64_t));
+}
+
+void RunWriter::WriteKey(const StateRecord& record) {
+    const uint16_t length = uint16_t(record.key.size());
+    Put(&record.hash, sizeof(record.hash));
+    Put(&length, sizeof(length));
+    Put(record.key.data(), record.key.size() * sizeof(uint64_t));
+}
+
+bool RunWriter::Close() {
+    m_file.close();
+    return !m_file.fail();
+}
+
+RunReader::RunReader(const std::filesystem::path& path) : m_buffer(IO_BUFFER) {
+    m_file.rdbuf()->pubsetbuf(m_buffer.data(), std::streamsize(m_buffer.size()));
+    m_file.open(path, std::ios::binary);
+}
+
+bool RunReader::Read(StateRecord& record) {
+    uint8_t move = 0;
+    uint16_t length = 0;
+    if (!Get(&record.hash, sizeof(record.hash)) || !Get(&record.parent, sizeof(record.parent)) ||
+        !Get(&move, sizeof(move)) || !Get(&length, sizeof(length))) {
+        return false;
+    }
+    record.move = Direction(move);
+    record.key.resize(length);
+    return Get(record.key.data(), length * sizeof(uint64_t));
+}
+
+bool RunReader::ReadKey(StateRecord& record) {
+    uint16_t length = 0;
+    if (!Get(&record.hash, sizeof(record.hash)) || !Get(&length, sizeof(length))) {
+        return false;
+    }
+    record.key.resize(length);
+    return Get(record.key.data(), length * sizeof(uint64_t));
+}
+
+SearchFiles::~SearchFiles() {
+    std::error_code error;
+    for (const auto& path : m_made) {
+        std::filesystem::remove(path, error);
+    }
+    if (m_createdDir) {
+        std::filesystem::remove(m_dir, error);
+    }
+}
+
+bool SearchFiles::Open() {
+    std::error_code error;
+    m_createdDir = std::filesystem::create_directories(m_dir, error);
+    return !error && std::filesystem::is_directory(m_dir, error);
+}
+
+void SearchFiles::Remove(const std::filesystem::path& path) {
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    std::erase(m_made, path);
+}
+
+std::filesystem::path SearchFiles::Make(const std::string& name) {
+    std::filesystem::path path = m_dir / (name + ".bin");
+    if (std::find(m_made.begin(), m_made.end(), path) == m_made.end()) {
+        m_made.push_back(path);
+    }
+    return path;
+}
+
+bool RunSorter::Add(const StateRecord& record) {
+    m_buffer.push_back(record);
+    m_bufferBytes += record.key.size() * sizeof(uint64_t) + RECORD_OVERHEAD;
+    return m_bufferBytes < m_memory || Spill();
+}
+
+// Sorts the buffer, keeps the first record of each state and writes them as a run
+bool RunSorter::Spill() {
+    TRACE_ZONE("RunSorter::Spill");
+    std::stable_sort(m_buffer.begin(), m_buffer.end());
+    m_runs.push_back(m_files.Run(m_numRuns++));
+    RunWriter writer(m_runs.back());
+    for (size_t i = 0; i < m_buffer.size(); ++i) {
+        if (i == 0 || !SameState(m_buffer[i], m_buffer[i - 1])) {
+            writer.Write(m_buffer[i]);
+        }
+    }
+    m_buffer.clear();
+    m_bufferBytes = 0;
+    return writer.Close();
+}
+
+// Merges runs, MAX_FAN_IN at a time, until at most MAX_FAN_IN are left, so a merge never holds
+// more files, or read buffers, open than that
+bool RunSorter::Compact() {
+    while (m_runs.size() > MAX_FAN_IN) {
+        TRACE_ZONE("RunSorter::Compact");
+        const std::span<const std::filesystem::path> group(m_runs.data(), MAX_FAN_IN);
+        const std::filesystem::path merged = m_files.Run(m_numRuns++);
+        RunMerger merger(group);
+        RunWriter writer(merged);
+        StateRecord record;
+        while (merger.Next(record)) {
+            writer.Write(record);
+        }
+        if (!merger.Ok() || !writer.Close()) {
+            return false;
+        }
+        for (const auto& run : group) {
+            m_files.Remove(run);
+        }
+        m_runs.erase(m_runs.begin(), m_runs.begin() + MAX_FAN_IN);
+        m_runs.push_back(merged);
+    }
+    return true;
+}
+
+MergeResult RunSorter::Merge(const std::filesystem::path& visited,
+    const std::filesystem::path& nextVisited, const std::filesystem::path& layer) {
+    TRACE_ZONE("RunSorter::Merge");
+    MergeResult result;
+    if ((!m_buffer.empty() && !Spill()) || !Compact()) {
+        return result;
+    }
+
+    {
+        RunMerger merger(m_runs);
+        RunReader seen(visited);
+        RunWriter seenOut(nextVisited);
+        RunWriter layerOut(layer);
+        if (!merger.Ok() || !seen.Ok()) {
+            return result;
+        }
+        StateRecord seenRecord;
+        bool hasSeen = seen.ReadKey(seenRecord);
+
+        StateRecord record;
+        while (merger.Next(record)) {
+            while (hasSeen && seenRecord < record) {
+                seenOut.WriteKey(seenRecord);
+                hasSeen = seen.ReadKey(seenRecord);
+            }
+            if (!hasSeen || !SameState(seenRecord, record)) {
+                seenOut.WriteKey(record);
+                layerOut.Write(record);
+                result.added++;
+            }
+        }
+        while (hasSeen) {
+            seenOut.WriteKey(seenRecord);
+            hasSeen = seen.ReadKey(seenRecord);
+        }
+        result.ok = seenOut.Close() && layerOut.Close();
+    }
+
+    for (const auto& run : m_runs) {
+        m_files.Remove(run);
+    }
+    m_runs.clear();
+    return result;
+}
+
+} // namespace BabaIsYou
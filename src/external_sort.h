@@ -0,0 +1,132 @@
+#pragma once
+
+#include "engine.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Sorted run files for the disk-backed searches: Solver's external mode and StateGraphExporter.
+// Files are only ever written front to back and read front to back. They live as long as one
+// search on one machine, so integers are written in native byte order.
+namespace BabaIsYou {
+
+// A state of a layer, or a successor waiting to be merged into the next one. Records sort by
+// hash, then key, and are the same state iff both match.
+struct StateRecord {
+    uint64_t hash = 0;         // HashCompactKey of the key
+    uint64_t parent = 0;       // hash of the state it was reached from
+    Direction move = Direction::Up; // the move from the parent
+    std::vector<uint64_t> key; // compact key, see compact_key.h
+};
+
+bool operator<(const StateRecord& a, const StateRecord& b);
+bool SameState(const StateRecord& a, const StateRecord& b);
+
+class RunWriter {
+  public:
+    explicit RunWriter(const std::filesystem::path& path);
+
+    // A record is u64 hash, u64 parent, u8 move, u16 key words, key; WriteKey leaves out the
+    // parent and move, for files of visited states
+    void Write(const StateRecord& record);
+    void WriteKey(const StateRecord& record);
+
+    // Flushes and closes; false if anything failed to be written
+    bool Close();
+
+  private:
+    void Put(const void* data, size_t size) {
+        m_file.write(static_cast<const char*>(data), std::streamsize(size));
+    }
+
+    std::vector<char> m_buffer;
+    std::ofstream m_file;
+};
+
+class RunReader {
+  public:
+    explicit RunReader(const std::filesystem::path& path);
+
+    // Return false at the end of the file
+    bool Read(StateRecord& record);
+    bool ReadKey(StateRecord& record);
+
+    bool Ok() const { return m_file.is_open(); }
+
+  private:
+    bool Get(void* data, size_t size) {
+        return bool(m_file.read(static_cast<char*>(data), std::streamsize(size)));
+    }
+
+    std::vector<char> m_buffer;
+    std::ifstream m_file;
+};
+
+// The files of one search in a directory of their own, removed with it, along with the
+// directory if the search created it
+class SearchFiles {
+  public:
+    explicit SearchFiles(std::filesystem::path dir) : m_dir(std::move(dir)) {}
+    ~SearchFiles();
+
+    SearchFiles(const SearchFiles&) = delete;
+    SearchFiles& operator=(const SearchFiles&) = delete;
+
+    // Creates the directory if needed; false if it cannot be
+    bool Open();
+
+    std::filesystem::path Layer(size_t depth) { return Make("layer-" + std::to_string(depth)); }
+    std::filesystem::path Run(size_t index) { return Make("run-" + std::to_string(index)); }
+    // Two files that take turns, the states seen so far and the ones after the next layer
+    std::filesystem::path Visited(size_t generation) {
+        return Make("visited-" + std::to_string(generation % 2));
+    }
+    void Remove(const std::filesystem::path& path);
+
+  private:
+    std::filesystem::path Make(const std::string& name);
+
+    std::filesystem::path m_dir;
+    bool m_createdDir = false;
+    std::vector<std::filesystem::path> m_made;
+};
+
+struct MergeResult {
+    bool ok = false;
+    size_t added = 0; // states new to the visited file, now in the layer
+};
+
+// Collects the successors of a layer in memory, spilling them as sorted runs whenever they
+// reach `memoryBytes`, then merges the runs into the next layer. Duplicates are dropped by
+// comparing full keys, so no two states are ever mistaken for one another.
+class RunSorter {
+  public:
+    RunSorter(SearchFiles& files, size_t memoryBytes) : m_files(files), m_memory(memoryBytes) {}
+
+    // False on an I/O failure
+    bool Add(const StateRecord& record);
+
+    // Merges everything added since the last call with `visited`, the sorted keys of every state
+    // seen so far: new states go to `layer`, and the keys of all states, old and new, to
+    // `nextVisited`. The runs are removed.
+    MergeResult Merge(const std::filesystem::path& visited,
+        const std::filesystem::path& nextVisited, const std::filesystem::path& layer);
+
+  private:
+    bool Spill();
+    bool Compact();
+
+    SearchFiles& m_files;
+    size_t m_memory;
+    std::vector<StateRecord> m_buffer;
+    size_t m_bufferBytes = 0;
+    std::vector<std::filesystem::path> m_runs;
+    size_t m_numRuns = 0; // names runs, never reused within the search
+};
+
+} // namespace BabaIsYou
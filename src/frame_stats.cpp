@@ -0,0 +1,47 @@
+#include "frame_stats.h"
+#include <algorithm>
+#include <array>
+#include <fstream>
+
+namespace BabaIsYou {
+
+FrameSummary FrameStats::Summarize() const {
+    const size_t count = m_samples.Size();
+    if (count == 0) {
+        return {};
+    }
+
+    std::array<float, FRAME_HISTORY> times;
+    for (size_t i = 0; i < count; ++i) {
+        times[i] = m_samples[i].frame;
+    }
+
+    auto percentile = [&times, count](float p) {
+        const size_t n = std::min(count - 1, size_t(p * count));
+        std::nth_element(times.begin(), times.begin() + n, times.begin() + count);
+        return times[n];
+    };
+
+    FrameSummary summary;
+    summary.p50 = percentile(0.50f);
+    summary.p99 = percentile(0.99f);
+    summary.max = *std::max_element(times.begin(), times.begin() + count);
+    return summary;
+}
+
+bool FrameStats::WriteCsv(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    file << "frame,update_ms,try_move_ms,draw_ms,end_drawing_ms,frame_ms\n";
+    for (size_t i = 0; i < m_samples.Size(); ++i) {
+        const FrameSample& s = m_samples[i];
+        file << i << ',' << s.update << ',' << s.tryMove << ',' << s.draw << ',' << s.endDrawing
+             << ',' << s.frame << '\n';
+    }
+    return bool(file);
+}
+
+} // namespace BabaIsYou
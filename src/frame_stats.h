@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ring_buffer.h"
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace BabaIsYou {
+
+constexpr size_t FRAME_HISTORY = 4096;
+
+// Section timings of one frame, in milliseconds
+struct FrameSample {
+    float update = 0.0f;
+    float tryMove = 0.0f; // part of update, 0 when no move was made
+    float draw = 0.0f;
+    float endDrawing = 0.0f; // includes the wait for the target frame rate
+    float frame = 0.0f;
+};
+
+struct FrameSummary {
+    float p50 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+};
+
+class FrameStats {
+  public:
+    void Push(const FrameSample& sample) { m_samples.Push(sample); }
+
+    const RingBuffer<FrameSample, FRAME_HISTORY>& Samples() const { return m_samples; }
+    FrameSummary Summarize() const;
+    bool WriteCsv(const std::string& path) const;
+
+  private:
+    RingBuffer<FrameSample, FRAME_HISTORY> m_samples;
+};
+
+// Adds the time spent in its scope to `outMs`
+class ScopedTimer {
+  public:
+    explicit ScopedTimer(float& outMs) : m_out(outMs), m_start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        const auto elapsed = std::chrono::steady_clock::now() - m_start;
+        m_out += std::chrono::duration<float, std::milli>(elapsed).count();
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+  private:
+    float& m_out;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace BabaIsYou
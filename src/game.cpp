@@ -1,72 +1,141 @@
 #include "game.h"
 #include "raylib.h"
+#include "trace.h"
 #include <algorithm>
-#include <cassert>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 namespace BabaIsYou {
 
+namespace {
+
+constexpr std::array<std::pair<int, InputAction>, 8> KEY_BINDINGS = { {
+    { KEY_W, InputAction::Up },
+    { KEY_S, InputAction::Down },
+    { KEY_A, InputAction::Left },
+    { KEY_D, InputAction::Right },
+    { KEY_X, InputAction::Undo },
+    { KEY_R, InputAction::Restart },
+    { KEY_N, InputAction::NextLevel },
+    { KEY_P, InputAction::PreviousLevel },
+} };
+
+void DrawObject(ObjectType object, Rectangle r) {
+    if (object == ObjectType::Wall) {
+        DrawRectangleRec(r, DARKGRAY);
+    } else if (object == ObjectType::Rock) {
+        DrawRectangleRounded({ r.x + 7.0f, r.y + 7.0f, TILE_PIXEL_SIZE - 14, TILE_PIXEL_SIZE - 14 },
+            0.3f, 6, { 150, 100, 60, 255 });
+    } else if (object == ObjectType::Flag) {
+        DrawRectangle(r.x + 15, r.y + 5, TILE_PIXEL_SIZE - 42, TILE_PIXEL_SIZE - 10, YELLOW);
+        DrawRectangle(r.x + 21, r.y + 5, 17, 16, YELLOW);
+    } else if (object == ObjectType::Baba) {
+        DrawRectangleRec({ r.x + 6, r.y + 6, TILE_PIXEL_SIZE - 12, TILE_PIXEL_SIZE - 12 }, BLUE);
+
+        // eyes
+        DrawRectangleRec({ r.x + 13, r.y + 15, 7, 7 }, BLACK);
+        DrawRectangleRec({ r.x + TILE_PIXEL_SIZE - 20, r.y + 15, 7, 7 }, BLACK);
+    } else if (IsText(object)) {
+        DrawRectangleRounded({ r.x + 6.0f, r.y + 6.0f, TILE_PIXEL_SIZE - 12, TILE_PIXEL_SIZE - 12 },
+            0.3f, 6, WHITE);
+        DrawText(TypeToStr(object).c_str(), r.x + 6.0f, r.y + 6.0f, 20, BLACK);
+    }
+}
+
+} // namespace
+
 Game::Game() {
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Sokoban");
     SetTargetFPS(60);
+    TRACE_DETAIL(true); // the move phases are recorded on the frame thread only
 
-    m_levelManager.LoadLevel(m_currentState);
-    Reset();
-
-    m_rules.Add(ObjectType::Baba, Property::You);
-    m_rules.Add(ObjectType::Wall, Property::Stop);
-    m_rules.Add(ObjectType::Flag, Property::Win);
-    m_rules.Add(ObjectType::Rock, Property::Push);
-
-    for (ObjectType i = ObjectType::TextBaba; i <= ObjectType::NumType; ++i) {
-        m_rules.Add(i, Property::Push);
+    // pick up where the last run left off
+    if (std::vector<uint8_t> saved; ReadSessionFile(SESSION_FILE, saved)) {
+        m_session.Restore(saved);
     }
+    m_hints.Request(m_session.ShareEngine(), m_session.GetState());
+    m_logicTime = GetTime();
 }
 
 Game::~Game() {
+    m_frameStats.WriteCsv(FRAME_STATS_CSV);
+    TRACE_WRITE(TRACE_JSON);
     CloseWindow();
 }
 
 void Game::Loop() {
     while (!WindowShouldClose()) {
-        Update();
-        Draw();
+        m_frame = FrameSample{};
+        {
+            ScopedTimer frameTimer(m_frame.frame);
+            {
+                ScopedTimer timer(m_frame.update);
+                Update();
+            }
+
+            BeginDrawing();
+            {
+                ScopedTimer timer(m_frame.draw);
+                Draw();
+            }
+            if (m_showHint) {
+                DrawHint();
+            }
+            if (m_showFrameStats) {
+                DrawFrameStats();
+            }
+            {
+                ScopedTimer timer(m_frame.endDrawing);
+                EndDrawing();
+            }
+        }
+        m_frameStats.Push(m_frame);
     }
 }
 
 void Game::Update() {
-    if (!m_currentState.isWin) {
-        if (IsKeyPressed(KEY_W)) {
-            TryMove(0, -1);
-        } else if (IsKeyPressed(KEY_S)) {
-            TryMove(0, 1);
-        } else if (IsKeyPressed(KEY_A)) {
-            TryMove(-1, 0);
-        } else if (IsKeyPressed(KEY_D)) {
-            TryMove(1, 0);
-        }
+    TRACE_ZONE("Game::Update");
+
+    const double now = GetTime();
+    PollInput(now);
+    m_tweens.Advance(GetFrameTime());
+
+    // logic runs at a fixed rate, whatever the frame rate
+    bool changed = false;
+    int ticks = 0;
+    while (m_logicTime + LOGIC_TICK <= now && ticks < MAX_TICKS_PER_FRAME) {
+        m_logicTime += LOGIC_TICK;
+        changed |= Tick(now);
+        ticks++;
+    }
+    if (ticks == MAX_TICKS_PER_FRAME) {
+        m_logicTime = now; // the missed ticks are dropped, the queued inputs are not
+    }
+
+    if (changed) {
+        SaveSession();
+        m_hints.Request(m_session.ShareEngine(), m_session.GetState());
     }
 
-    if (IsKeyPressed(KEY_R)) {
-        m_levelManager.LoadLevel(m_currentState);
-        Reset();
-    } else if (IsKeyPressed(KEY_N)) {
-        m_levelManager.NextLevel(m_currentState);
-        Reset();
-    } else if (IsKeyPressed(KEY_P)) {
-        m_levelManager.PreviousLevel(m_currentState);
-        Reset();
-    } else if (IsKeyPressed(KEY_X)) {
-        Undo();
+    if (IsKeyPressed(KEY_H)) {
+        m_showHint = !m_showHint;
+    }
+    if (IsKeyPressed(KEY_F3)) {
+        m_showFrameStats = !m_showFrameStats;
     }
 }
 
 void Game::Draw() const {
-    BeginDrawing();
+    TRACE_ZONE("Game::Draw");
+
     ClearBackground({ 20, 20, 20, 255 });
 
+    const GameState& state = m_session.GetState();
     for (int y = 0; y < LEVEL_HEIGHT; ++y) {
         for (int x = 0; x < LEVEL_WIDTH; ++x) {
-            const Tile& tile = m_currentState.tiles[y][x];
+            const TileObjects tile = state.At(x, y);
             Rectangle r = { x * TILE_PIXEL_SIZE, y * TILE_PIXEL_SIZE, TILE_PIXEL_SIZE,
                 TILE_PIXEL_SIZE };
 
@@ -74,179 +143,182 @@ void Game::Draw() const {
             DrawRectangleLines(
                 (int)r.x, (int)r.y, (int)r.width, (int)r.height, { 30, 30, 30, 255 });
 
+            // objects still sliding in are drawn by their tween instead
+            std::array<int, NUM_OBJECT_TYPES> sliding{};
             for (const auto object : tile) {
-                if (object == ObjectType::Wall) {
-                    DrawRectangleRec(r, DARKGRAY);
-                } else if (object == ObjectType::Rock) {
-                    DrawRectangleRounded(
-                        { r.x + 7.0f, r.y + 7.0f, TILE_PIXEL_SIZE - 14, TILE_PIXEL_SIZE - 14 },
-                        0.3f, 6, { 150, 100, 60, 255 });
-                } else if (object == ObjectType::Flag) {
-                    DrawRectangle(
-                        r.x + 15, r.y + 5, TILE_PIXEL_SIZE - 42, TILE_PIXEL_SIZE - 10, YELLOW);
-                    DrawRectangle(r.x + 21, r.y + 5, 17, 16, YELLOW);
-                } else if (object == ObjectType::Baba) {
-                    DrawRectangleRec(
-                        { r.x + 6, r.y + 6, TILE_PIXEL_SIZE - 12, TILE_PIXEL_SIZE - 12 }, BLUE);
-
-                    // eyes
-                    DrawRectangleRec({ r.x + 13, r.y + 15, 7, 7 }, BLACK);
-                    DrawRectangleRec({ r.x + TILE_PIXEL_SIZE - 20, r.y + 15, 7, 7 }, BLACK);
-                } else if (IsText(object)) {
-                    DrawRectangleRounded(
-                        { r.x + 6.0f, r.y + 6.0f, TILE_PIXEL_SIZE - 12, TILE_PIXEL_SIZE - 12 },
-                        0.3f, 6, WHITE);
-                    DrawText(TypeToStr(object).c_str(), r.x + 6.0f, r.y + 6.0f, 20, BLACK);
+                if (sliding[int(object)] < m_tweens.CountArriving(ToIndex(x, y), object)) {
+                    sliding[int(object)]++;
+                    continue;
                 }
+                DrawObject(object, r);
             }
         }
     }
 
-    if (m_currentState.isWin) {
+    const float t = m_tweens.Progress();
+    for (const auto& tween : m_tweens.Active()) {
+        const auto [fromX, fromY] = ToPos(tween.from);
+        const auto [toX, toY] = ToPos(tween.to);
+        const float x = fromX + (toX - fromX) * t;
+        const float y = fromY + (toY - fromY) * t;
+        DrawObject(tween.type,
+            { x * TILE_PIXEL_SIZE, y * TILE_PIXEL_SIZE, TILE_PIXEL_SIZE, TILE_PIXEL_SIZE });
+    }
+
+    if (state.IsWin()) {
         DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, { 50, 50, 50, 150 });
         DrawText("You Win!", SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 25, 50, GREEN);
     }
-
-    EndDrawing();
 }
 
-void Game::Reset() {
-    m_historyStart = 0;
-    m_historyCount = 0;
-    SaveState();
-}
-
-bool Game::InBounds(int x, int y) {
-    return x >= 0 && x < LEVEL_WIDTH && y >= 0 && y < LEVEL_HEIGHT;
-}
+void Game::DrawFrameStats() const {
+    constexpr int GRAPH_FRAMES = 240;
+    constexpr int GRAPH_HEIGHT = 80;
+    constexpr float GRAPH_MAX_MS = 50.0f;
+    constexpr float TARGET_MS = 1000.0f / 60.0f;
 
-bool Game::VecContains(const std::vector<ObjectType>& v, ObjectType type) {
-    return std::find(v.begin(), v.end(), type) != v.end();
-}
+    const auto& samples = m_frameStats.Samples();
+    if (samples.IsEmpty()) {
+        return;
+    }
 
-bool Game::AllPushable(const Tile& tile, const std::vector<ObjectType>& pushObjects) const {
-    for (const auto obj : tile) {
-        if (VecContains(pushObjects, obj)) {
-            return true;
-        }
+    const FrameSummary summary = m_frameStats.Summarize();
+    const FrameSample& last = samples.Back();
+
+    const int x0 = 10;
+    const int y0 = 10;
+    DrawRectangle(x0, y0, GRAPH_FRAMES + 20, GRAPH_HEIGHT + 90, { 0, 0, 0, 200 });
+
+    DrawText(TextFormat("frame p50 %.2f  p99 %.2f  max %.2f ms", summary.p50, summary.p99,
+                 summary.max),
+        x0 + 10, y0 + 8, 10, RAYWHITE);
+    DrawText(TextFormat("update %.3f  move %.3f ms", last.update, last.tryMove), x0 + 10, y0 + 24,
+        10, RAYWHITE);
+    DrawText(TextFormat("draw %.3f  end %.3f ms", last.draw, last.endDrawing), x0 + 10, y0 + 40,
+        10, RAYWHITE);
+
+    // frame time graph, newest on the right
+    const int graphBottom = y0 + 70 + GRAPH_HEIGHT;
+    const size_t count = std::min(samples.Size(), size_t(GRAPH_FRAMES));
+    for (size_t i = 0; i < count; ++i) {
+        const float ms = samples[samples.Size() - count + i].frame;
+        const int h = int(std::min(ms, GRAPH_MAX_MS) / GRAPH_MAX_MS * GRAPH_HEIGHT);
+        const Color color = ms > 2 * TARGET_MS ? RED : (ms > TARGET_MS * 1.1f ? ORANGE : GREEN);
+        DrawLine(x0 + 10 + int(i), graphBottom, x0 + 10 + int(i), graphBottom - h, color);
     }
-    return false;
-}
 
-void Game::TryMove(int dx, int dy) {
-    const auto& youObjects = m_rules.Get(Property::You);
-    const auto& pushObjects = m_rules.Get(Property::Push);
-    const auto& stopObjects = m_rules.Get(Property::Stop);
-    const auto& winObjects = m_rules.Get(Property::Win);
+    const int targetY = graphBottom - int(TARGET_MS / GRAPH_MAX_MS * GRAPH_HEIGHT);
+    DrawLine(x0 + 10, targetY, x0 + 10 + GRAPH_FRAMES, targetY, { 255, 255, 255, 120 });
+}
 
-    std::vector<std::pair<Vec2i, ObjectType>> yous;
-    for (int y = 0; y < LEVEL_HEIGHT; ++y) {
-        for (int x = 0; x < LEVEL_WIDTH; ++x) {
-            for (const auto obj : m_currentState.tiles[y][x]) {
-                if (VecContains(youObjects, obj)) {
-                    yous.emplace_back(Vec2i{ x, y }, obj);
-                }
-            }
-        }
+// Outlines the tile each You would step onto; the search itself runs on the hint thread
+void Game::DrawHint() const {
+    const Hint hint = m_hints.Get();
+    const char* label = "hint: thinking...";
+    if (hint.status == HintStatus::Idle) {
+        return;
+    } else if (hint.status == HintStatus::NoSolution) {
+        label = "hint: no solution";
+    } else if (hint.status == HintStatus::Ready) {
+        label = TextFormat("hint: %c", ToChar(hint.move));
     }
+    DrawText(label, 10, SCREEN_HEIGHT - 30, 20, YELLOW);
 
-    if (yous.empty()) {
+    if (hint.status != HintStatus::Ready) {
         return;
     }
-
-    auto proj = [dx, dy](const Vec2i& pos) { return pos.x * dx + pos.y * dy; };
-    std::sort(yous.begin(), yous.end(),
-        [&proj](const auto& a, const auto& b) { return proj(a.first) > proj(b.first); });
-
-    SaveState();
-
-    for (const auto& [pos, type] : yous) {
-        const int nx = pos.x + dx;
-        const int ny = pos.y + dy;
-
-        if (!InBounds(nx, ny) || m_currentState.tiles[ny][nx].Contains(stopObjects)) {
-            continue;
+    const GameState& state = m_session.GetState();
+    const auto [dx, dy] = ToDelta(hint.move);
+    for (const auto type : m_session.GetEngine().GetRules().Get(Property::You)) {
+        for (const auto index : state.Positions(type)) {
+            const auto [x, y] = ToPos(index);
+            DrawRectangleLinesEx({ (x + dx) * TILE_PIXEL_SIZE, (y + dy) * TILE_PIXEL_SIZE,
+                                     TILE_PIXEL_SIZE, TILE_PIXEL_SIZE },
+                3.0f, YELLOW);
         }
+    }
+}
 
-        int cx = nx;
-        int cy = ny;
-
-        while (InBounds(cx, cy) && !m_currentState.tiles[cy][cx].IsEmpty() &&
-            AllPushable(m_currentState.tiles[cy][cx], pushObjects)) {
-            cx += dx;
-            cy += dy;
-        }
-
-        if (!InBounds(cx, cy) || m_currentState.tiles[cy][cx].Contains(stopObjects)) {
-            continue;
-        }
-
-        // perform shift
-        while (cx != nx || cy != ny) {
-            const int prevX = cx - dx;
-            const int prevY = cy - dy;
-
-            auto& source = m_currentState.tiles[prevY][prevX];
-            auto& dest = m_currentState.tiles[cy][cx];
-
-            for (const auto obj : source) {
-                if (VecContains(pushObjects, obj)) {
-                    source.Remove(ObjectType::Rock);
-                    dest.Push(obj);
-                }
+// Every key press is queued, however many arrive in one frame
+void Game::PollInput(double now) {
+    for (int key = GetKeyPressed(); key != 0; key = GetKeyPressed()) {
+        for (const auto& [bound, action] : KEY_BINDINGS) {
+            if (bound == key) {
+                m_input.Press(action, now);
             }
-
-            cx = prevX;
-            cy = prevY;
-        }
-
-        // move the You object
-        auto& source_you = m_currentState.tiles[pos.y][pos.x];
-        if (source_you.Remove(type)) {
-            m_currentState.tiles[ny][nx].Push(type);
         }
     }
-
-    // check for win
-    m_currentState.isWin = false;
-    for (int y = 0; y < LEVEL_HEIGHT; ++y) {
-        for (int x = 0; x < LEVEL_WIDTH; ++x) {
-            if (m_currentState.tiles[y][x].Contains(youObjects) &&
-                m_currentState.tiles[y][x].Contains(winObjects)) {
-                m_currentState.isWin = true;
-                return;
-            }
+    for (const auto& [key, action] : KEY_BINDINGS) {
+        if (IsKeyUp(key)) {
+            m_input.Release(action);
         }
     }
+    m_input.Repeat(now);
 }
 
-void Game::SaveState() {
-    size_t index = (m_historyStart + m_historyCount) % MAX_HISTORY;
-
-    m_history[index] = GameState(m_currentState.tiles, m_currentState.isWin);
-
-    if (m_historyCount < MAX_HISTORY) {
-        m_historyCount++;
-    } else {
-        m_historyStart = (m_historyStart + 1) % MAX_HISTORY;
+// Applies at most one queued input. Input waits while a level is on its way, as the level would
+// replace whatever it did.
+bool Game::Tick(double now) {
+    bool changed = SwapInLevel();
+    InputEvent event;
+    if (m_pendingLevel < 0 && m_input.Pop(now, event)) {
+        changed |= Apply(event.action);
     }
+    return changed;
 }
 
-void Game::LoadState(const GameState& gs) {
-    m_currentState.tiles = gs.tiles;
-    m_currentState.isWin = gs.isWin;
+bool Game::Apply(InputAction action) {
+    const bool won = m_session.GetState().IsWin();
+    const int level = m_session.GetLevels().CurrentIndex();
+    switch (action) {
+        case InputAction::Up: return !won && TryMove(Direction::Up);
+        case InputAction::Down: return !won && TryMove(Direction::Down);
+        case InputAction::Left: return !won && TryMove(Direction::Left);
+        case InputAction::Right: return !won && TryMove(Direction::Right);
+        case InputAction::Undo:
+            m_session.Undo();
+            m_tweens.Clear();
+            return true;
+        case InputAction::Restart: GoToLevel(level); break;
+        case InputAction::NextLevel: GoToLevel(level + 1); break;
+        case InputAction::PreviousLevel: GoToLevel(level - 1); break;
+        case InputAction::NumAction: break;
+    }
+    return SwapInLevel();
 }
 
-void Game::Undo() {
-    if (m_historyCount == 0) {
+// Levels are built on the loader's thread; the frame only ever swaps a finished one in
+void Game::GoToLevel(int index) {
+    if (index < 0 || index >= m_session.GetLevels().Count()) {
         return;
     }
+    m_levelLoader.Prepare(index, m_session.GetLevels().GetLevel(index));
+    m_pendingLevel = index;
+}
 
-    size_t index = (m_historyStart + m_historyCount - 1) % MAX_HISTORY;
+bool Game::SwapInLevel() {
+    if (m_pendingLevel < 0 || !m_levelLoader.Poll(m_pendingLevel, m_levelBuffer)) {
+        return false;
+    }
+    m_session.SelectLevel(m_pendingLevel, m_levelBuffer);
+    m_pendingLevel = -1;
+    m_tweens.Clear();
+    return true;
+}
 
-    LoadState(m_history[index]);
+bool Game::TryMove(Direction dir) {
+    ScopedTimer timer(m_frame.tryMove);
+    if (!m_session.TryMove(dir)) {
+        return false;
+    }
+    m_tweens.Start(m_session.GetLastChanges());
+    return true;
+}
 
-    m_historyCount--;
+// Forks the states here; the writer's thread encodes and writes them
+void Game::SaveSession() {
+    m_session.Snapshot(*m_sessionSnapshot);
+    m_sessionWriter.Submit(m_sessionSnapshot);
 }
 
 } // namespace BabaIsYou
\ No newline at end of file
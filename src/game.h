@@ -1,16 +1,26 @@
 #pragma once
 
-#include "bimap.h"
+#include "frame_stats.h"
+#include "hint_solver.h"
+#include "input_queue.h"
+#include "level_loader.h"
 #include "level.h"
+#include "session.h"
+#include "session_file.h"
 #include "tile.h"
-#include <string>
-#include <vector>
+#include "tween.h"
+#include <memory>
 
 namespace BabaIsYou {
 
 constexpr int SCREEN_WIDTH = TILE_PIXEL_SIZE * LEVEL_WIDTH;
 constexpr int SCREEN_HEIGHT = TILE_PIXEL_SIZE * LEVEL_HEIGHT;
-constexpr size_t MAX_HISTORY = 512;
+constexpr const char* FRAME_STATS_CSV = "frame_times.csv";
+constexpr const char* TRACE_JSON = "trace.json";
+constexpr const char* SESSION_FILE = "session.bin";
+constexpr double LOGIC_TICK = 1.0 / 120.0; // seconds
+constexpr int MAX_TICKS_PER_FRAME = 16;    // beyond this, a stalled frame skips logic time
+constexpr KeyRepeat KEY_REPEAT = { .delay = 0.2, .interval = 0.1 };
 
 class Game {
   public:
@@ -21,32 +31,37 @@ class Game {
 
   private:
     void Update();
+    void PollInput(double now);
+    bool Tick(double now);
+    bool Apply(InputAction action);
     void Draw() const;
+    void DrawFrameStats() const;
+    void DrawHint() const;
 
-    void Reset();
+    bool TryMove(Direction dir);
+    void GoToLevel(int index);
+    bool SwapInLevel();
+    void SaveSession();
 
-    static bool InBounds(int x, int y);
-    static bool VecContains(const std::vector<ObjectType>& v, ObjectType type);
-    bool AllPushable(const Tile& tile, const std::vector<ObjectType>& pushObjects) const;
-    void TryMove(int dx, int dy);
+    Session m_session;
 
-    void SaveState();
-    void LoadState(const GameState& gs);
-    void Undo();
+    TweenPool m_tweens;
 
-    struct Vec2i {
-        int x;
-        int y;
-    };
+    InputQueue m_input{ KEY_REPEAT };
+    double m_logicTime = 0.0; // time of the last logic tick
+    SessionWriter m_sessionWriter{ SESSION_FILE };
+    std::unique_ptr<SessionSnapshot> m_sessionSnapshot = std::make_unique<SessionSnapshot>();
 
-    GameState m_currentState;
-    LevelManager m_levelManager;
+    LevelLoader m_levelLoader;
+    GameState m_levelBuffer; // receives the prepared level, then holds the one it replaced
+    int m_pendingLevel = -1;  // level waiting on the loader, -1 if none
 
-    BiMap<ObjectType, Property> m_rules;
+    HintSolver m_hints;
+    bool m_showHint = false;
 
-    std::array<GameState, MAX_HISTORY> m_history;
-    size_t m_historyStart = 0; // oldest saved
-    size_t m_historyCount = 0; // how many valid snapshots
+    FrameStats m_frameStats;
+    FrameSample m_frame; // timings of the frame in progress
+    bool m_showFrameStats = false;
 };
 
 } // namespace BabaIsYou
\ No newline at end of file
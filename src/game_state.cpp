@@ -0,0 +1,220 @@
+#include "game_state.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+namespace BabaIsYou {
+
+namespace {
+
+// Sole owner of a block that another thread may have shared until just now. The acquire fence
+// pairs with the release in that thread's shared_ptr destructor, so its reads of the block are
+// done before we write to it.
+template <typename T>
+bool IsUnique(const std::shared_ptr<T>& block) {
+    if (block.use_count() != 1) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
+
+} // namespace
+
+bool TileObjects::SpilledContains(ObjectType type) const {
+    for (const auto& entry : m_spilled) {
+        if (entry.type == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TileObjects::SpilledContains(const std::vector<ObjectType>& types) const {
+    for (const auto& entry : m_spilled) {
+        if (std::find(types.begin(), types.end(), entry.type) != types.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+GameState::GameState() {
+    Clear();
+}
+
+TileRow& GameState::MutableRow(int y) {
+    if (!IsUnique(m_rows[y])) {
+        m_rows[y] = std::allocate_shared<TileRow>(PoolAllocator<TileRow>(), *m_rows[y]);
+    }
+    return *m_rows[y];
+}
+
+GameState::Index& GameState::MutableIndex() {
+    if (!IsUnique(m_index)) {
+        m_index = std::allocate_shared<Index>(PoolAllocator<Index>(), *m_index);
+    }
+    return *m_index;
+}
+
+EntityPool& GameState::MutableEntities() {
+    if (!IsUnique(m_entities)) {
+        m_entities = std::allocate_shared<EntityPool>(PoolAllocator<EntityPool>(), *m_entities);
+    }
+    return *m_entities;
+}
+
+SpillTable& GameState::MutableSpill() {
+    if (!IsUnique(m_spill)) {
+        m_spill = std::allocate_shared<SpillTable>(PoolAllocator<SpillTable>(), *m_spill);
+    }
+    return *m_spill;
+}
+
+// Puts an object on top of a tile, spilling it when the inline objects are full
+void GameState::PutObject(int x, int y, ObjectType type, uint16_t slot) {
+    if (!MutableRow(y)[x].Push(type, slot)) {
+        MutableSpill().Push(ToIndex(x, y), type, slot);
+    }
+}
+
+// Takes the lowest object of `type` off a tile that holds one. Taking an inline object from a
+// spilled tile moves the bottom spilled object down into the inline entries.
+void GameState::TakeObject(int x, int y, ObjectType type, uint16_t& slot) {
+    Tile& tile = MutableRow(y)[x];
+    if (tile.Remove(type, slot)) {
+        if (tile.Size() >= MAX_OBJECT_PER_TILE) {
+            const SpillTable::Entry bottom = MutableSpill().PopBottom(ToIndex(x, y));
+            tile.Refill(bottom.type, bottom.slot);
+        }
+        return;
+    }
+    [[maybe_unused]] const bool spilled = MutableSpill().Remove(ToIndex(x, y), type, slot);
+    assert(spilled);
+    tile.RemoveSpilled();
+}
+
+bool GameState::Push(int x, int y, ObjectType type) {
+    if (TileAt(x, y).Size() >= MAX_STACK_HEIGHT) {
+        return false;
+    }
+    const uint16_t slot = MutableEntities().Create(type);
+    if (slot == NO_SLOT) {
+        return false;
+    }
+    PutObject(x, y, type, slot);
+    IndexAdd(type, ToIndex(x, y));
+    return true;
+}
+
+bool GameState::Remove(int x, int y, ObjectType type) {
+    if (!At(x, y).Contains(type)) {
+        return false;
+    }
+    uint16_t slot;
+    TakeObject(x, y, type, slot);
+    MutableEntities().Destroy(slot);
+    IndexRemove(type, ToIndex(x, y));
+    return true;
+}
+
+EntityId GameState::Move(int fromX, int fromY, int toX, int toY, ObjectType type) {
+    if (!At(fromX, fromY).Contains(type) || TileAt(toX, toY).Size() >= MAX_STACK_HEIGHT) {
+        return NO_ENTITY;
+    }
+    uint16_t slot;
+    TakeObject(fromX, fromY, type, slot);
+    PutObject(toX, toY, type, slot);
+    IndexMove(type, ToIndex(fromX, fromY), ToIndex(toX, toY));
+    return m_entities->Handle(slot);
+}
+
+bool GameState::Locate(EntityId id, Vec2i& pos) const {
+    const ObjectType type = m_entities->Type(id);
+    if (type == ObjectType::Empty) {
+        return false;
+    }
+    for (const auto index : Positions(type)) {
+        pos = ToPos(index);
+        const TileObjects tile = At(pos.x, pos.y);
+        for (size_t i = 0; i < tile.Size(); ++i) {
+            if (tile.SlotAt(i) == id.slot) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Every empty board shares the same blocks, so default construction and Clear do not allocate
+void GameState::ReservePool(size_t forks) const {
+    PoolKeep(forks * LEVEL_HEIGHT); // the rows are the most numerous blocks
+    std::vector<GameState> copies(forks, *this);
+    for (GameState& copy : copies) {
+        for (int y = 0; y < LEVEL_HEIGHT; ++y) {
+            copy.MutableRow(y);
+        }
+        copy.MutableIndex();
+        copy.MutableEntities();
+        copy.MutableSpill();
+    }
+}
+
+void GameState::Clear() {
+    static const auto emptyRow = std::make_shared<TileRow>();
+    static const auto emptyIndex = std::make_shared<Index>();
+    static const auto emptyEntities = std::make_shared<EntityPool>();
+    static const auto emptySpill = std::make_shared<SpillTable>();
+    m_rows.fill(emptyRow);
+    m_index = emptyIndex;
+    m_entities = emptyEntities;
+    m_spill = emptySpill;
+    m_isWin = false;
+}
+
+// Opens a slot at the end of the group of `type` by moving the first entry of every later group
+// to that group's end, so an insert costs O(types) rather than shifting the whole array.
+void GameState::IndexAdd(ObjectType type, uint16_t index) {
+    auto& [offsets, positions] = MutableIndex();
+    assert(offsets.back() < MAX_INDEXED_OBJECTS);
+    positions.push_back(0);
+
+    const int t = int(type);
+    for (int g = NUM_OBJECT_TYPES - 1; g > t; --g) {
+        positions[offsets[g + 1]] = positions[offsets[g]];
+        offsets[g + 1]++;
+    }
+    positions[offsets[t + 1]] = index;
+    offsets[t + 1]++;
+}
+
+// Mirror of IndexAdd: fills the hole with the group's last entry, then moves the last entry of
+// every later group one slot down.
+void GameState::IndexRemove(ObjectType type, uint16_t index) {
+    auto& [offsets, positions] = MutableIndex();
+    const int t = int(type);
+    const auto first = positions.begin() + offsets[t];
+    const auto last = positions.begin() + offsets[t + 1];
+    const auto it = std::find(first, last, index);
+    assert(it != last);
+
+    *it = *(last - 1);
+    for (int g = t + 1; g < NUM_OBJECT_TYPES; ++g) {
+        positions[offsets[g] - 1] = positions[offsets[g + 1] - 1];
+        offsets[g]--;
+    }
+    offsets[NUM_OBJECT_TYPES]--;
+    positions.pop_back();
+}
+
+// Objects of one type are in no particular order, so a move only rewrites its own entry
+void GameState::IndexMove(ObjectType type, uint16_t from, uint16_t to) {
+    auto& [offsets, positions] = MutableIndex();
+    const auto first = positions.begin() + offsets[int(type)];
+    const auto last = positions.begin() + offsets[int(type) + 1];
+    const auto it = std::find(first, last, from);
+    assert(it != last);
+    *it = to;
+}
+
+} // namespace BabaIsYou
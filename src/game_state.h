@@ -0,0 +1,174 @@
+#pragma once
+
+#include "block_pool.h"
+#include "entity_pool.h"
+#include "spill_table.h"
+#include "tile.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace BabaIsYou {
+
+constexpr int LEVEL_WIDTH = 33;
+constexpr int LEVEL_HEIGHT = 18;
+constexpr int NUM_TILES = LEVEL_WIDTH * LEVEL_HEIGHT;
+constexpr size_t MAX_INDEXED_OBJECTS = MAX_ENTITIES;
+constexpr int NUM_OBJECT_TYPES = int(ObjectType::NumType);
+
+struct Vec2i {
+    int x;
+    int y;
+};
+
+constexpr uint16_t ToIndex(int x, int y) {
+    return uint16_t(y * LEVEL_WIDTH + x);
+}
+
+constexpr Vec2i ToPos(uint16_t index) {
+    return { index % LEVEL_WIDTH, index / LEVEL_WIDTH };
+}
+
+using TileRow = std::array<Tile, LEVEL_WIDTH>;
+
+// Every object on one tile, bottom first: the inline ones, then those that spilled. A view into
+// a GameState, valid until the state next changes.
+class TileObjects {
+  public:
+    class Iterator {
+      public:
+        Iterator(const TileObjects& tile, size_t i) : m_tile(&tile), m_i(i) {}
+        ObjectType operator*() const { return (*m_tile)[m_i]; }
+        Iterator& operator++() {
+            ++m_i;
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return m_i == other.m_i; }
+
+      private:
+        const TileObjects* m_tile;
+        size_t m_i;
+    };
+
+    TileObjects(const Tile& tile, std::span<const SpillTable::Entry> spilled)
+        : m_tile(tile), m_spilled(spilled) {}
+
+    size_t Size() const { return m_tile.Size(); }
+    bool IsEmpty() const { return m_tile.IsEmpty(); }
+    bool IsSpilled() const { return m_tile.IsSpilled(); }
+    bool Contains(ObjectType type) const {
+        return m_tile.Contains(type) || (!m_spilled.empty() && SpilledContains(type));
+    }
+    bool Contains(const std::vector<ObjectType>& types) const {
+        return m_tile.Contains(types) || (!m_spilled.empty() && SpilledContains(types));
+    }
+
+    ObjectType operator[](size_t i) const {
+        return i < MAX_OBJECT_PER_TILE ? m_tile.TypeAt(i)
+                                       : m_spilled[i - MAX_OBJECT_PER_TILE].type;
+    }
+    uint16_t SlotAt(size_t i) const {
+        return i < MAX_OBJECT_PER_TILE ? m_tile.SlotAt(i)
+                                       : m_spilled[i - MAX_OBJECT_PER_TILE].slot;
+    }
+    ObjectType Top() const { return (*this)[Size() - 1]; }
+
+    Iterator begin() const { return { *this, 0 }; }
+    Iterator end() const { return { *this, Size() }; }
+
+  private:
+    bool SpilledContains(ObjectType type) const;
+    bool SpilledContains(const std::vector<ObjectType>& types) const;
+
+    const Tile& m_tile;
+    std::span<const SpillTable::Entry> m_spilled;
+};
+
+// The board. All changes go through Push/Remove/Move, which keep a per-type index of object
+// positions so that finding every object of a type costs O(count) instead of O(board).
+//
+// Every object is an entity of the board's EntityPool: Push creates one, Remove destroys it, and
+// Move carries it to another tile, so its EntityId follows the object for as long as it exists.
+//
+// A tile keeps MAX_OBJECT_PER_TILE objects inline and the rest of its stack in the board's
+// SpillTable, which At() reads only for a tile that has spilled.
+//
+// Rows, the index, the pool and the spill table are shared copy-on-write blocks: copying a state
+// forks it in O(1), and the fork copies a block the first time it changes it. A move therefore
+// copies only the few rows it touches, and states that branch from one another share everything
+// else. Forks may live on different threads; a single state must not be used from two threads
+// at once. Blocks come from the block pool (block_pool.h), so forking and changing states
+// recycles memory rather than allocating it.
+class GameState {
+  public:
+    GameState();
+
+    TileObjects At(int x, int y) const {
+        const Tile& tile = (*m_rows[y])[x];
+        return { tile, tile.IsSpilled() ? m_spill->At(ToIndex(x, y))
+                                        : std::span<const SpillTable::Entry>() };
+    }
+
+    // Fails when the tile already holds MAX_STACK_HEIGHT objects or the pool is full
+    bool Push(int x, int y, ObjectType type);
+    bool Remove(int x, int y, ObjectType type);
+    void Clear();
+
+    // Moves the lowest object of `type` between tiles, keeping its entity. Returns NO_ENTITY,
+    // changing nothing, when there is no such object or the destination is full.
+    EntityId Move(int fromX, int fromY, int toX, int toY, ObjectType type);
+
+    // Entity of the i-th object from the bottom of a tile
+    EntityId IdAt(int x, int y, size_t i) const { return m_entities->Handle(At(x, y).SlotAt(i)); }
+    const EntityPool& Entities() const { return *m_entities; }
+
+    // Finds the tile of a live entity, in O(objects of its type)
+    bool Locate(EntityId id, Vec2i& pos) const;
+
+    // Tile index of every object of `type`, one entry per object, in no particular order
+    std::span<const uint16_t> Positions(ObjectType type) const {
+        return { m_index->positions.data() + m_index->offsets[int(type)],
+            m_index->positions.data() + m_index->offsets[int(type) + 1] };
+    }
+    size_t Count(ObjectType type) const {
+        return m_index->offsets[int(type) + 1] - m_index->offsets[int(type)];
+    }
+
+    bool IsWin() const { return m_isWin; }
+    void SetWin(bool isWin) { m_isWin = isWin; }
+
+    // Fills the calling thread's block pool with the blocks of `forks` forks of this state that
+    // each changed every block, the most that many forks can hold at once, and keeps them there
+    void ReservePool(size_t forks) const;
+
+  private:
+    const Tile& TileAt(int x, int y) const { return (*m_rows[y])[x]; }
+
+    struct Index {
+        // positions grouped by type: type t owns [offsets[t], offsets[t + 1])
+        std::array<uint16_t, NUM_OBJECT_TYPES + 1> offsets{};
+        // sized to the object count, so a copy stays small
+        std::vector<uint16_t, PoolAllocator<uint16_t>> positions;
+    };
+
+    TileRow& MutableRow(int y);
+    Index& MutableIndex();
+    EntityPool& MutableEntities();
+    SpillTable& MutableSpill();
+    void TakeObject(int x, int y, ObjectType type, uint16_t& slot);
+    void PutObject(int x, int y, ObjectType type, uint16_t slot);
+    void IndexAdd(ObjectType type, uint16_t index);
+    void IndexRemove(ObjectType type, uint16_t index);
+    void IndexMove(ObjectType type, uint16_t from, uint16_t to);
+
+    std::array<std::shared_ptr<TileRow>, LEVEL_HEIGHT> m_rows;
+    std::shared_ptr<Index> m_index;
+    std::shared_ptr<EntityPool> m_entities;
+    std::shared_ptr<SpillTable> m_spill;
+    bool m_isWin = false;
+};
+
+} // namespace BabaIsYou
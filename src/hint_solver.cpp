@@ -0,0 +1,80 @@
+#include "hint_solver.h"
+#include "trace.h"
+#include <utility>
+
+namespace BabaIsYou {
+
+HintSolver::HintSolver(const SolverOptions& options)
+    : m_options(options), m_thread(&HintSolver::Run, this) {}
+
+HintSolver::~HintSolver() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+        m_cancel = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void HintSolver::Request(std::shared_ptr<const Engine> engine, const GameState& state) {
+    TRACE_ZONE("HintSolver::Request");
+    {
+        std::lock_guard lock(m_mutex);
+        m_engine = std::move(engine);
+        m_state = state;
+        m_hasJob = true;
+        m_generation++;
+        m_hint = { state.IsWin() ? HintStatus::Idle : HintStatus::Searching };
+        m_cancel = true;
+    }
+    m_wake.notify_one();
+}
+
+Hint HintSolver::Get() const {
+    std::lock_guard lock(m_mutex);
+    return m_hint;
+}
+
+void HintSolver::Run() {
+    SolverOptions options = m_options;
+    options.cancel = &m_cancel;
+
+    for (;;) {
+        std::shared_ptr<const Engine> engine;
+        GameState state;
+        uint64_t generation;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_hasJob || m_stop; });
+            if (m_stop) {
+                return;
+            }
+            engine = m_engine;
+            state = m_state;
+            generation = m_generation;
+            m_hasJob = false;
+            m_cancel = false;
+        }
+
+        if (state.IsWin()) {
+            continue;
+        }
+
+        TRACE_ZONE("HintSolver::Search");
+        const SolverResult result = Solver(*engine).Solve(state, options);
+
+        std::lock_guard lock(m_mutex);
+        if (generation != m_generation) {
+            continue;
+        }
+        Direction move;
+        if (result.solved && !result.moves.empty() && FromChar(result.moves[0], move)) {
+            m_hint = { HintStatus::Ready, move };
+        } else {
+            m_hint = { HintStatus::NoSolution };
+        }
+    }
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "engine.h"
+#include "game_state.h"
+#include "solver.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace BabaIsYou {
+
+enum class HintStatus {
+    Idle,      // nothing requested, or the position is already won
+    Searching,
+    Ready,
+    NoSolution // unsolvable, or not solved within the state limit
+};
+
+struct Hint {
+    HintStatus status = HintStatus::Idle;
+    Direction move = Direction::Up; // first move of a shortest solution when Ready
+};
+
+// Looks for the next move of a shortest solution on a worker thread. Request hands over the
+// position and returns at once, cancelling any search still running for an older position; Get
+// only reads the last result. Neither waits on the search.
+class HintSolver {
+  public:
+    explicit HintSolver(const SolverOptions& options = {});
+    ~HintSolver();
+
+    HintSolver(const HintSolver&) = delete;
+    HintSolver& operator=(const HintSolver&) = delete;
+
+    // `engine` is shared, not copied, so it must not change afterwards; Session::ShareEngine
+    // hands out such snapshots
+    void Request(std::shared_ptr<const Engine> engine, const GameState& state);
+    Hint Get() const;
+
+  private:
+    void Run();
+
+    SolverOptions m_options;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    // position to search next: shared rules and a fork of the caller's state
+    std::shared_ptr<const Engine> m_engine;
+    GameState m_state;
+    bool m_hasJob = false;
+    bool m_stop = false;
+    uint64_t m_generation = 0; // bumped by every request; results of older ones are dropped
+    Hint m_hint;
+
+    std::atomic<bool> m_cancel{ false };
+    std::thread m_thread; // last, so it starts after everything it uses
+};
+
+} // namespace BabaIsYou
@@ -0,0 +1,61 @@
+#include "input_queue.h"
+
+namespace BabaIsYou {
+
+InputQueue::InputQueue(const KeyRepeat& repeat) : m_repeat(repeat) {
+    m_nextRepeat.fill(-1.0);
+}
+
+// moving and undoing repeat; level changes fire once per press
+bool InputQueue::Repeats(InputAction action) {
+    return action <= InputAction::Undo;
+}
+
+void InputQueue::Press(InputAction action, double time) {
+    Push({ action, time });
+    if (Repeats(action) && m_repeat.interval > 0.0) {
+        m_nextRepeat[int(action)] = time + m_repeat.delay;
+    }
+}
+
+void InputQueue::Release(InputAction action) {
+    m_nextRepeat[int(action)] = -1.0;
+}
+
+void InputQueue::Repeat(double now) {
+    // several held keys interleave by due time
+    for (;;) {
+        int next = -1;
+        for (int action = 0; action < NUM_INPUT_ACTIONS; ++action) {
+            const double due = m_nextRepeat[action];
+            if (due >= 0.0 && due <= now && (next < 0 || due < m_nextRepeat[next])) {
+                next = action;
+            }
+        }
+        if (next < 0) {
+            return;
+        }
+        Push({ InputAction(next), m_nextRepeat[next] });
+        m_nextRepeat[next] += m_repeat.interval;
+    }
+}
+
+bool InputQueue::Pop(double until, InputEvent& event) {
+    if (m_count == 0 || m_events[m_head].time > until) {
+        return false;
+    }
+    event = m_events[m_head];
+    m_head = (m_head + 1) % INPUT_QUEUE_CAPACITY;
+    m_count--;
+    return true;
+}
+
+void InputQueue::Push(const InputEvent& event) {
+    if (m_count == INPUT_QUEUE_CAPACITY) {
+        return;
+    }
+    m_events[(m_head + m_count) % INPUT_QUEUE_CAPACITY] = event;
+    m_count++;
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace BabaIsYou {
+
+enum class InputAction {
+    Up,
+    Down,
+    Left,
+    Right,
+    Undo,
+    Restart,
+    NextLevel,
+    PreviousLevel,
+
+    NumAction
+};
+constexpr int NUM_INPUT_ACTIONS = int(InputAction::NumAction);
+constexpr size_t INPUT_QUEUE_CAPACITY = 256;
+
+// Held keys repeat after `delay`, then every `interval` seconds; interval <= 0 turns repeat off
+struct KeyRepeat {
+    double delay = 0.25;
+    double interval = 0.1;
+};
+
+struct InputEvent {
+    InputAction action;
+    double time; // seconds, on the caller's clock
+};
+
+// Key presses and their repeats, in time order, waiting for the logic to take them. Repeats are
+// scheduled from the press time rather than from frames, so a held key moves at the same speed
+// whatever the frame rate. Fixed capacity; once full, new events are dropped.
+class InputQueue {
+  public:
+    explicit InputQueue(const KeyRepeat& repeat = {});
+
+    void Press(InputAction action, double time);
+    void Release(InputAction action);
+
+    // Queues the repeats of held keys that fall due up to `now`
+    void Repeat(double now);
+
+    // Takes the oldest event stamped no later than `until`
+    bool Pop(double until, InputEvent& event);
+
+    size_t Size() const { return m_count; }
+    bool IsEmpty() const { return m_count == 0; }
+
+  private:
+    static bool Repeats(InputAction action);
+    void Push(const InputEvent& event);
+
+    KeyRepeat m_repeat;
+    std::array<double, NUM_INPUT_ACTIONS> m_nextRepeat; // < 0 when the key is up
+
+    std::array<InputEvent, INPUT_QUEUE_CAPACITY> m_events;
+    size_t m_head = 0; // oldest
+    size_t m_count = 0;
+};
+
+} // namespace BabaIsYou
@@ -1,5 +1,6 @@
 #include "level.h"
 #include <cassert>
+#include <string>
 
 namespace BabaIsYou {
 
@@ -68,7 +69,7 @@ const std::array<Level, NUM_LEVEL> LevelManager::m_Levels ={{
 }};
 // clang-format on
 
-LevelManager::LevelManager() {
+LevelManager::LevelManager() : m_levels(m_Levels.begin(), m_Levels.end()) {
     m_charToTile.fill(ObjectType::Empty);
     m_charToTile['#'] = ObjectType::Wall;
     m_charToTile['0'] = ObjectType::Rock;
@@ -78,33 +79,46 @@ LevelManager::LevelManager() {
     assert(int(ObjectType::NumType) - int(ObjectType::TextBaba) <= 26);
 
     char c = 'A';
-    for (ObjectType i = ObjectType::TextBaba; i <= ObjectType::NumType; ++i) {
+    for (ObjectType i = ObjectType::TextBaba; i < ObjectType::NumType; ++i) {
         m_charToTile[c++] = i;
     }
+
+    m_tileToChar.fill(' ');
+    for (int ch = 0; ch < 256; ++ch) {
+        if (m_charToTile[ch] != ObjectType::Empty) {
+            m_tileToChar[int(m_charToTile[ch])] = char(ch);
+        }
+    }
+}
+
+bool LevelManager::IsValidChar(char c) const {
+    return c == ' ' || m_charToTile[(unsigned char)c] != ObjectType::Empty;
 }
 
 void LevelManager::LoadLevel(GameState& gs) const {
+    Build(GetLevel(m_currentLevel), gs);
+}
+
+void LevelManager::Build(const Level& level, GameState& gs) const {
+    gs.Clear();
     for (int y = 0; y < LEVEL_HEIGHT; ++y) {
         for (int x = 0; x < LEVEL_WIDTH; ++x) {
-            gs.tiles[y][x] = Tile{};
-            char c = GetLevel(m_currentLevel)[y][x];
+            char c = level[y][x];
             if (c == ' ') {
                 continue;
             }
 
-            if (m_charToTile[c] != ObjectType::Empty) {
-                gs.tiles[y][x].Push(m_charToTile[c]);
+            if (m_charToTile[(unsigned char)c] != ObjectType::Empty) {
+                gs.Push(x, y, m_charToTile[(unsigned char)c]);
             } else {
                 assert(false);
             }
         }
     }
-
-    gs.isWin = false;
 }
 
 void LevelManager::NextLevel(GameState& gs) {
-    if (m_currentLevel + 1 < NUM_LEVEL) {
+    if (m_currentLevel + 1 < Count()) {
         m_currentLevel++;
         LoadLevel(gs);
     }
@@ -117,9 +131,66 @@ void LevelManager::PreviousLevel(GameState& gs) {
     }
 }
 
+bool LevelManager::SelectLevel(int index, GameState& gs) {
+    if (!SetCurrentIndex(index)) {
+        return false;
+    }
+    LoadLevel(gs);
+    return true;
+}
+
+bool LevelManager::SetCurrentIndex(int index) {
+    if (index < 0 || index >= Count()) {
+        return false;
+    }
+    m_currentLevel = index;
+    return true;
+}
+
+bool LevelManager::LoadPack(std::istream& in) {
+    std::vector<Level> levels;
+    Level level;
+    int row = 0;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (row == 0 && (line.empty() || line[0] == ';')) {
+            continue;
+        }
+        if (line.size() > LEVEL_WIDTH) {
+            return false;
+        }
+
+        level[row].fill('\0');
+        for (int x = 0; x < LEVEL_WIDTH; ++x) {
+            const char c = x < int(line.size()) ? line[x] : ' ';
+            if (!IsValidChar(c)) {
+                return false;
+            }
+            level[row][x] = c;
+        }
+
+        if (++row == LEVEL_HEIGHT) {
+            levels.push_back(level);
+            row = 0;
+        }
+    }
+
+    if (row != 0 || levels.empty()) {
+        return false;
+    }
+
+    m_levels = std::move(levels);
+    m_currentLevel = 0;
+    return true;
+}
+
 const Level& LevelManager::GetLevel(int index) const {
-    assert(index < NUM_LEVEL && index >= 0);
-    return m_Levels[index];
+    assert(index < Count() && index >= 0);
+    return m_levels[index];
 }
 
 } // namespace BabaIsYou
@@ -1,19 +1,15 @@
 #pragma once
 
+#include "game_state.h"
 #include "tile.h"
 #include <array>
+#include <istream>
+#include <vector>
 
 namespace BabaIsYou {
 
-constexpr int LEVEL_WIDTH = 33;
-constexpr int LEVEL_HEIGHT = 18;
 constexpr int NUM_LEVEL = 3;
 
-struct GameState {
-    std::array<std::array<Tile, LEVEL_WIDTH>, LEVEL_HEIGHT> tiles;
-    bool isWin;
-};
-
 using Level = std::array<std::array<char, LEVEL_WIDTH + 1>, LEVEL_HEIGHT>;
 
 class LevelManager {
@@ -23,14 +19,33 @@ class LevelManager {
     void LoadLevel(GameState& gs) const;
     void NextLevel(GameState& gs);
     void PreviousLevel(GameState& gs);
+    bool SelectLevel(int index, GameState& gs);
 
-  private:
+    // Makes `index` current without building it, for a state that was built elsewhere
+    bool SetCurrentIndex(int index);
+
+    // Builds `level` into `gs`. Only reads the character tables, which never change after
+    // construction, so any thread may call it.
+    void Build(const Level& level, GameState& gs) const;
+
+    // Replaces the built-in levels with a pack: LEVEL_HEIGHT rows per level, rows shorter than
+    // LEVEL_WIDTH are padded with floor, blank lines and lines starting with ';' are skipped.
+    bool LoadPack(std::istream& in);
+
+    int Count() const { return int(m_levels.size()); }
+    int CurrentIndex() const { return m_currentLevel; }
     const Level& GetLevel(int index) const;
+    char ToChar(ObjectType type) const { return m_tileToChar[int(type)]; }
+
+  private:
+    bool IsValidChar(char c) const;
 
     int m_currentLevel = 0;
     static const std::array<Level, NUM_LEVEL> m_Levels;
+    std::vector<Level> m_levels;
 
     std::array<ObjectType, 256> m_charToTile{};
+    std::array<char, int(ObjectType::NumType)> m_tileToChar{};
 };
 
 } // namespace BabaIsYou
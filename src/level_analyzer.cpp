@@ -0,0 +1,174 @@
+#include "level_analyzer.h"
+#include "compact_key.h"
+#include "solver.h"
+#include "trace.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace BabaIsYou {
+
+namespace {
+
+constexpr int32_t NO_NODE = -1;
+
+struct Node {
+    int32_t parent;
+    Direction move;
+    bool isWin;
+    std::array<int32_t, 4> next; // successor per direction, NO_NODE for none or itself
+};
+
+} // namespace
+
+LevelMetrics LevelAnalyzer::Analyze(const GameState& start, size_t maxStates) const {
+    TRACE_ZONE("LevelAnalyzer::Analyze");
+
+    LevelMetrics metrics;
+    const CompactKeyCodec codec(m_engine, start);
+    CompactKeySet visited(codec.Words());
+    std::vector<Node> nodes; // node i has key i in `visited`
+
+    std::vector<uint64_t> key(codec.Words());
+    codec.Encode(start, key);
+    visited.Insert(key);
+    nodes.push_back({ NO_NODE, Direction::Up, start.IsWin(), {} });
+
+    int32_t firstWin = start.IsWin() ? 0 : NO_NODE;
+    size_t expanded = 0;
+    size_t edges = 0;
+    bool full = false;
+
+    GameState state;
+    GameState next;
+    size_t head = 0;
+    for (; head < nodes.size() && !full; ++head) {
+        nodes[head].next.fill(NO_NODE);
+        if (nodes[head].isWin) {
+            continue;
+        }
+        codec.Decode(visited.Key(int32_t(head)), state);
+        expanded++;
+
+        for (const Direction dir : DIRECTIONS) {
+            next = state;
+            if (!m_engine.Step(next, dir)) {
+                break;
+            }
+            codec.Encode(next, key);
+            int32_t child = visited.Find(key);
+            if (child == int32_t(head)) {
+                continue;
+            }
+
+            if (child == NO_NODE) {
+                if (visited.Size() >= maxStates) {
+                    full = true;
+                    break;
+                }
+                child = visited.Insert(key).first;
+                nodes.push_back({ int32_t(head), dir, next.IsWin(), {} });
+                if (next.IsWin() && firstWin == NO_NODE) {
+                    firstWin = child;
+                }
+            }
+
+            // two directions may lead to the same state; count it once
+            auto& successors = nodes[head].next;
+            if (std::find(successors.begin(), successors.end(), child) == successors.end()) {
+                successors[int(dir)] = child;
+                edges++;
+            }
+        }
+    }
+
+    metrics.states = nodes.size();
+    metrics.complete = !full && head == nodes.size();
+    metrics.branching = expanded ? double(edges) / double(expanded) : 0.0;
+
+    if (firstWin != NO_NODE) {
+        metrics.solvable = true;
+        std::string moves;
+        for (int32_t node = firstWin; nodes[node].parent != NO_NODE; node = nodes[node].parent) {
+            moves.push_back(ToChar(nodes[node].move));
+        }
+        std::reverse(moves.begin(), moves.end());
+        metrics.optimalMoves = moves.size();
+        metrics.pushes = CountPushes(m_engine, start, moves);
+    }
+
+    if (metrics.complete) {
+        // reverse edges in CSR form, then a backward search from every win
+        std::vector<int32_t> offsets(nodes.size() + 1, 0);
+        for (const auto& node : nodes) {
+            for (const int32_t child : node.next) {
+                if (child != NO_NODE) {
+                    offsets[child + 1]++;
+                }
+            }
+        }
+        for (size_t i = 1; i < offsets.size(); ++i) {
+            offsets[i] += offsets[i - 1];
+        }
+        std::vector<int32_t> parents(offsets.back());
+        std::vector<int32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            for (const int32_t child : nodes[i].next) {
+                if (child != NO_NODE) {
+                    parents[fill[child]++] = int32_t(i);
+                }
+            }
+        }
+
+        std::vector<uint8_t> canWin(nodes.size(), 0);
+        std::vector<int32_t> queue;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i].isWin) {
+                canWin[i] = 1;
+                queue.push_back(int32_t(i));
+            }
+        }
+        for (size_t q = 0; q < queue.size(); ++q) {
+            const int32_t node = queue[q];
+            for (int32_t p = offsets[node]; p < offsets[node + 1]; ++p) {
+                if (!canWin[parents[p]]) {
+                    canWin[parents[p]] = 1;
+                    queue.push_back(parents[p]);
+                }
+            }
+        }
+        metrics.deadlocks = nodes.size() - queue.size();
+    }
+    return metrics;
+}
+
+std::vector<LevelMetrics> LevelAnalyzer::AnalyzeAll(
+    const LevelManager& levels, const AnalyzerOptions& options) const {
+    std::vector<LevelMetrics> results(levels.Count());
+    std::atomic<int> next{ 0 };
+    auto work = [&] {
+        GameState start;
+        for (int i = next.fetch_add(1); i < levels.Count(); i = next.fetch_add(1)) {
+            levels.Build(levels.GetLevel(i), start);
+            start.SetWin(m_engine.CheckWin(start));
+            results[i] = Analyze(start, options.maxStates);
+        }
+    };
+
+    const unsigned numThreads =
+        options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < std::min(numThreads, unsigned(levels.Count())); ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return results;
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "engine.h"
+#include "level.h"
+#include <cstddef>
+#include <vector>
+
+namespace BabaIsYou {
+
+struct AnalyzerOptions {
+    size_t maxStates = 200'000; // per level; a larger space is reported as incomplete
+    unsigned threads = 0;       // 0 for one per core
+};
+
+struct LevelMetrics {
+    bool solvable = false;   // a win was found within maxStates
+    bool complete = false;   // the whole reachable space was explored within maxStates
+    size_t optimalMoves = 0; // length of a shortest solution, when solvable
+    size_t pushes = 0;       // moves of that solution that push
+    size_t states = 0;       // distinct reachable states seen, wins included
+    double branching = 0;    // distinct successors per expanded state, self-loops left out
+    size_t deadlocks = 0;    // states no win is reachable from; only counted when complete
+};
+
+// Difficulty metrics of a level from its reachable state graph. A breadth-first search expands
+// every state but wins, recording each state's successors; the first win found gives the optimal
+// length, and a backward search from all wins over the recorded edges finds the states that
+// cannot be won any more.
+class LevelAnalyzer {
+  public:
+    explicit LevelAnalyzer(const Engine& engine) : m_engine(engine) {}
+
+    LevelMetrics Analyze(const GameState& start, size_t maxStates) const;
+
+    // Every level of `levels`, one worker per level at a time; results are in level order
+    std::vector<LevelMetrics> AnalyzeAll(
+        const LevelManager& levels, const AnalyzerOptions& options) const;
+
+  private:
+    const Engine& m_engine;
+};
+
+} // namespace BabaIsYou
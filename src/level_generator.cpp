@@ -0,0 +1,146 @@
+#include "level_generator.h"
+#include "solver.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace BabaIsYou {
+
+namespace {
+
+bool IsValid(const GeneratorOptions& o) {
+    return o.width >= 2 && o.height >= 2 && o.width + 2 <= LEVEL_WIDTH &&
+        o.height + 2 <= LEVEL_HEIGHT && o.minWalls >= 0 && o.minWalls <= o.maxWalls &&
+        o.minRocks >= 0 && o.minRocks <= o.maxRocks &&
+        o.maxWalls + o.maxRocks + 2 <= o.width * o.height && o.minMoves <= o.maxMoves;
+}
+
+// splitmix64, so that neighbouring candidates get unrelated streams
+uint64_t Mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+// The standard distributions and std::shuffle differ between library implementations, so the
+// draw uses the raw engine output to keep a seed's levels the same everywhere
+void LevelGenerator::Draw(uint64_t index, const GeneratorOptions& options, Level& level) const {
+    std::mt19937_64 rng(Mix(options.seed ^ Mix(index)));
+    auto pick = [&rng](uint64_t n) { return size_t(rng() % n); };
+
+    for (auto& row : level) {
+        row.fill(' ');
+        row[LEVEL_WIDTH] = '\0';
+    }
+
+    const char wall = m_levels.ToChar(ObjectType::Wall);
+    for (int x = 0; x < options.width + 2; ++x) {
+        level[0][x] = wall;
+        level[options.height + 1][x] = wall;
+    }
+    for (int y = 1; y <= options.height; ++y) {
+        level[y][0] = wall;
+        level[y][options.width + 1] = wall;
+    }
+
+    const int numWalls = options.minWalls + int(pick(options.maxWalls - options.minWalls + 1));
+    const int numRocks = options.minRocks + int(pick(options.maxRocks - options.minRocks + 1));
+
+    std::vector<char> objects(numWalls, wall);
+    objects.resize(numWalls + numRocks, m_levels.ToChar(ObjectType::Rock));
+    objects.push_back(m_levels.ToChar(ObjectType::Baba));
+    objects.push_back(m_levels.ToChar(ObjectType::Flag));
+
+    // a partial Fisher-Yates shuffle of the room's cells picks one distinct cell per object
+    std::vector<Vec2i> cells;
+    for (int y = 1; y <= options.height; ++y) {
+        for (int x = 1; x <= options.width; ++x) {
+            cells.push_back({ x, y });
+        }
+    }
+    for (size_t i = 0; i < objects.size(); ++i) {
+        std::swap(cells[i], cells[i + pick(cells.size() - i)]);
+        level[cells[i].y][cells[i].x] = objects[i];
+    }
+}
+
+bool LevelGenerator::TryCandidate(
+    uint64_t index, const GeneratorOptions& options, GeneratedLevel& out) const {
+    TRACE_ZONE("LevelGenerator::TryCandidate");
+
+    Draw(index, options, out.level);
+    GameState start;
+    m_levels.Build(out.level, start);
+
+    SolverOptions solverOptions;
+    solverOptions.maxStates = options.maxStates;
+    const SolverResult result = Solver(m_engine).Solve(start, solverOptions);
+    if (!result.solved || result.moves.size() < options.minMoves ||
+        result.moves.size() > options.maxMoves) {
+        return false;
+    }
+
+    out.pushes = CountPushes(m_engine, start, result.moves);
+    if (options.requirePush && out.pushes == 0) {
+        return false;
+    }
+    out.solution = result.moves;
+    out.statesVisited = result.statesVisited;
+    out.candidate = index;
+    return true;
+}
+
+// Workers take candidate indices in order and stop taking new ones once enough are accepted.
+// Every index below the last one taken is then tried, so the first `count` accepted by index are
+// the same on every run.
+GeneratorResult LevelGenerator::Generate(size_t count, const GeneratorOptions& options) const {
+    GeneratorResult result;
+    if (!IsValid(options) || count == 0) {
+        return result;
+    }
+
+    std::atomic<uint64_t> next{ 0 };
+    std::atomic<size_t> accepted{ 0 };
+    std::mutex mutex;
+    auto work = [&] {
+        GeneratedLevel level;
+        while (accepted.load(std::memory_order_relaxed) < count) {
+            const uint64_t index = next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= options.maxCandidates) {
+                break;
+            }
+            if (TryCandidate(index, options, level)) {
+                accepted.fetch_add(1, std::memory_order_relaxed);
+                std::lock_guard lock(mutex);
+                result.levels.push_back(level);
+            }
+        }
+    };
+
+    const unsigned numThreads =
+        options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < numThreads; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::sort(result.levels.begin(), result.levels.end(),
+        [](const auto& a, const auto& b) { return a.candidate < b.candidate; });
+    if (result.levels.size() > count) {
+        result.levels.resize(count);
+    }
+    result.candidates = size_t(std::min(next.load(), options.maxCandidates));
+    return result;
+}
+
+} // namespace BabaIsYou
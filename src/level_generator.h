@@ -0,0 +1,66 @@
+#pragma once
+
+#include "engine.h"
+#include "level.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace BabaIsYou {
+
+struct GeneratorOptions {
+    int width = 10; // room interior; the room and its wall border sit at the board's top left
+    int height = 7;
+    int minWalls = 4; // Stop walls placed inside the room
+    int maxWalls = 14;
+    int minRocks = 2; // Push rocks
+    int maxRocks = 6;
+    size_t minMoves = 12; // shortest solution must fall in [minMoves, maxMoves]
+    size_t maxMoves = 60;
+    bool requirePush = true;            // drop levels that can be won without pushing anything
+    size_t maxStates = 100'000;         // solver budget per candidate, over it is unsolvable
+    uint64_t maxCandidates = 1'000'000; // give up after trying this many
+    unsigned threads = 0;               // 0 for one per core
+    uint64_t seed = 1;
+};
+
+struct GeneratedLevel {
+    Level level;
+    std::string solution; // a shortest one
+    size_t pushes = 0;    // moves of the solution that push
+    size_t statesVisited = 0;
+    uint64_t candidate = 0; // index of the candidate it came from
+};
+
+struct GeneratorResult {
+    std::vector<GeneratedLevel> levels; // in candidate order
+    size_t candidates = 0;              // tried, accepted or not
+};
+
+// Makes random levels and keeps those the solver proves solvable within the move range.
+//
+// A candidate is a walled room holding random walls, rocks, one Baba and one Flag, under the
+// engine's rules. Candidate i is drawn from its own generator seeded from (seed, i), and the
+// result keeps the first `count` accepted candidates by index, so the output depends on the
+// options alone and not on the thread count or timing.
+class LevelGenerator {
+  public:
+    LevelGenerator(const Engine& engine, const LevelManager& levels)
+        : m_engine(engine), m_levels(levels) {}
+
+    // Returns fewer than `count` levels only when the options are out of range or maxCandidates
+    // runs out
+    GeneratorResult Generate(size_t count, const GeneratorOptions& options) const;
+
+    // Draws candidate `index` and returns true if it is accepted
+    bool TryCandidate(uint64_t index, const GeneratorOptions& options, GeneratedLevel& out) const;
+
+  private:
+    void Draw(uint64_t index, const GeneratorOptions& options, Level& level) const;
+
+    const Engine& m_engine;
+    const LevelManager& m_levels;
+};
+
+} // namespace BabaIsYou
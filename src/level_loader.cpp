@@ -0,0 +1,69 @@
+#include "level_loader.h"
+#include "trace.h"
+#include <utility>
+
+namespace BabaIsYou {
+
+LevelLoader::LevelLoader() : m_thread(&LevelLoader::Run, this) {}
+
+LevelLoader::~LevelLoader() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void LevelLoader::Prepare(int index, const Level& level) {
+    {
+        std::lock_guard lock(m_mutex);
+        if (index == m_queuedIndex || (m_queuedIndex < 0 && index == m_readyIndex)) {
+            return;
+        }
+        m_queued = level;
+        m_queuedIndex = index;
+    }
+    m_wake.notify_one();
+}
+
+bool LevelLoader::Poll(int index, GameState& out) const {
+    std::lock_guard lock(m_mutex);
+    if (index != m_readyIndex) {
+        return false;
+    }
+    out = m_ready;
+    return true;
+}
+
+void LevelLoader::Run() {
+    Level level;
+    GameState back;
+    for (;;) {
+        int index;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_queuedIndex >= 0 || m_stop; });
+            if (m_stop) {
+                return;
+            }
+            level = m_queued;
+            index = m_queuedIndex;
+        }
+
+        {
+            TRACE_ZONE("LevelLoader::Build");
+            m_builder.Build(level, back);
+        }
+
+        std::lock_guard lock(m_mutex);
+        std::swap(m_ready, back);
+        m_readyIndex = index;
+        // a newer request that came in meanwhile stays queued
+        if (m_queuedIndex == index) {
+            m_queuedIndex = -1;
+        }
+    }
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "game_state.h"
+#include "level.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace BabaIsYou {
+
+// Builds levels on a worker thread into a back buffer, so switching levels on the frame thread
+// is only a swap. Prepare queues a level, replacing any queued one; Poll hands out a fork of the
+// prepared level once it is ready. The prepared level stays until the next one replaces it, so
+// polling the same index again, to restart a level, is immediate.
+class LevelLoader {
+  public:
+    LevelLoader();
+    ~LevelLoader();
+
+    LevelLoader(const LevelLoader&) = delete;
+    LevelLoader& operator=(const LevelLoader&) = delete;
+
+    // Levels are keyed by index: asking again for the index already queued or ready does nothing
+    void Prepare(int index, const Level& level);
+
+    // Forks the prepared level into `out` and returns true when `index` is ready
+    bool Poll(int index, GameState& out) const;
+
+  private:
+    void Run();
+
+    LevelManager m_builder; // for its character tables only
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    Level m_queued;
+    int m_queuedIndex = -1; // -1: nothing to build
+    GameState m_ready;      // the front buffer Poll hands out
+    int m_readyIndex = -1;
+    bool m_stop = false;
+
+    std::thread m_thread; // last, so it starts after everything it uses
+};
+
+} // namespace BabaIsYou
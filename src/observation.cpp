@@ -0,0 +1,56 @@
+#include "observation.h"
+#include "trace.h"
+
+namespace BabaIsYou {
+
+void ObservationEncoder::SetRules(const Engine& engine) {
+    const auto& rules = engine.GetRules();
+    for (int property = 0; property < NUM_PROPERTIES; ++property) {
+        uint16_t mask = 0;
+        for (const auto type : rules.Get(Property(property))) {
+            mask |= uint16_t(1u << int(type));
+        }
+        m_propertyMasks[property] = mask;
+    }
+}
+
+template <typename T>
+void ObservationEncoder::Encode(const GameState& gs, T* out) const {
+    TRACE_ZONE("ObservationEncoder::Encode");
+    for (int index = 0; index < NUM_TILES; ++index) {
+        EncodeTile(gs, uint16_t(index), out);
+    }
+}
+
+template <typename T>
+void ObservationEncoder::Update(const GameState& gs, const ChangeSet& changes, T* out) const {
+    for (const auto index : changes.Tiles()) {
+        EncodeTile(gs, index, out);
+    }
+}
+
+template <typename T>
+void ObservationEncoder::EncodeTile(const GameState& gs, uint16_t index, T* out) const {
+    const auto [x, y] = ToPos(index);
+    const TileObjects tile = gs.At(x, y);
+
+    uint16_t mask = tile.IsEmpty() ? uint16_t(1u << int(ObjectType::Empty)) : 0;
+    for (const auto obj : tile) {
+        mask |= uint16_t(1u << int(obj));
+    }
+
+    T* plane = out + index;
+    for (int type = 0; type < NUM_OBJECT_TYPES; ++type, plane += NUM_TILES) {
+        *plane = T((mask >> type) & 1);
+    }
+    for (int property = 0; property < NUM_PROPERTIES; ++property, plane += NUM_TILES) {
+        *plane = T((mask & m_propertyMasks[property]) != 0);
+    }
+}
+
+template void ObservationEncoder::Encode(const GameState&, uint8_t*) const;
+template void ObservationEncoder::Encode(const GameState&, float*) const;
+template void ObservationEncoder::Update(const GameState&, const ChangeSet&, uint8_t*) const;
+template void ObservationEncoder::Update(const GameState&, const ChangeSet&, float*) const;
+
+} // namespace BabaIsYou
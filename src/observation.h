@@ -0,0 +1,43 @@
+#pragma once
+
+#include "change_set.h"
+#include "engine.h"
+#include "game_state.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace BabaIsYou {
+
+constexpr int NUM_PROPERTIES = 4;
+constexpr int NUM_OBSERVATION_PLANES = NUM_OBJECT_TYPES + NUM_PROPERTIES;
+constexpr size_t OBSERVATION_SIZE = size_t(NUM_OBSERVATION_PLANES) * NUM_TILES;
+
+// Writes a GameState into a caller's buffer as one-hot planes, plane by plane and row by row
+// within a plane. There is one plane per ObjectType, with the Empty plane marking tiles that hold
+// nothing, then one per Property, set on tiles holding any object that has it under the current
+// rules. A property no rule uses leaves its plane at zero, so the layout never changes.
+//
+// Encode fills the whole buffer. After a step, Update rewrites only the tiles in the step's
+// ChangeSet, which is all that can differ while the rules stay the same. After a rule change,
+// call SetRules and Encode again.
+class ObservationEncoder {
+  public:
+    explicit ObservationEncoder(const Engine& engine) { SetRules(engine); }
+
+    void SetRules(const Engine& engine);
+
+    // T is uint8_t or float; `out` holds OBSERVATION_SIZE elements
+    template <typename T>
+    void Encode(const GameState& gs, T* out) const;
+    template <typename T>
+    void Update(const GameState& gs, const ChangeSet& changes, T* out) const;
+
+  private:
+    template <typename T>
+    void EncodeTile(const GameState& gs, uint16_t index, T* out) const;
+
+    std::array<uint16_t, NUM_PROPERTIES> m_propertyMasks{}; // one bit per ObjectType
+};
+
+} // namespace BabaIsYou
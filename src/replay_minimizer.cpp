@@ -0,0 +1,170 @@
+#include "replay_minimizer.h"
+#include "compact_key.h"
+#include "trace.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <queue>
+#include <tuple>
+#include <vector>
+
+namespace BabaIsYou {
+
+namespace {
+
+constexpr int32_t NO_NODE = -1;
+
+struct Node {
+    int depth; // moves from the nearest replay state
+    bool isWin;
+    std::array<int32_t, 4> next; // successor per direction, NO_NODE for none, itself or outside
+    uint8_t pushes;              // bit per direction, set if that move pushes
+};
+
+// Moves along `parents` from the start to `node`
+std::string PathTo(const std::vector<std::pair<int32_t, Direction>>& parents, int32_t node) {
+    std::string moves;
+    for (; parents[node].first != NO_NODE; node = parents[node].first) {
+        moves.push_back(ToChar(parents[node].second));
+    }
+    std::reverse(moves.begin(), moves.end());
+    return moves;
+}
+
+} // namespace
+
+MinimizedReplay ReplayMinimizer::Minimize(const GameState& start,
+    std::span<const GameState> played, const MinimizerOptions& options) const {
+    TRACE_ZONE("ReplayMinimizer::Minimize");
+
+    MinimizedReplay result;
+    const auto& youObjects = m_engine.GetRules().Get(Property::You);
+
+    const CompactKeyCodec codec(m_engine, start);
+    CompactKeySet visited(codec.Words());
+    std::vector<Node> nodes; // node i has key i in `visited`
+    std::vector<uint64_t> key(codec.Words());
+    auto add = [&](const GameState& gs, int depth) {
+        codec.Encode(gs, key);
+        const auto [node, inserted] = visited.Insert(key);
+        if (inserted) {
+            nodes.push_back({ depth, gs.IsWin(), {}, 0 });
+        }
+        return node;
+    };
+
+    // every state the replay went through, undone ones included, is a source at depth 0
+    bool won = start.IsWin();
+    add(start, 0);
+    for (const GameState& state : played) {
+        if (won) {
+            break;
+        }
+        add(state, 0);
+        won = state.IsWin();
+    }
+    if (!won) {
+        return result;
+    }
+    result.won = true;
+
+    // the neighbourhood, breadth first from all sources; edges leaving it are dropped
+    GameState state;
+    GameState next;
+    ChangeSet changes;
+    for (size_t head = 0; head < nodes.size(); ++head) {
+        nodes[head].next.fill(NO_NODE);
+        if (nodes[head].isWin) {
+            continue;
+        }
+        codec.Decode(visited.Key(int32_t(head)), state);
+
+        for (const Direction dir : DIRECTIONS) {
+            next = state;
+            changes.Clear();
+            if (!m_engine.Step(next, dir, &changes)) {
+                break;
+            }
+            codec.Encode(next, key);
+            int32_t child = visited.Find(key);
+            if (child == int32_t(head)) {
+                continue;
+            }
+            if (child == NO_NODE && nodes[head].depth < options.radius &&
+                visited.Size() < options.maxStates) {
+                child = add(next, nodes[head].depth + 1);
+            }
+            if (child == NO_NODE) {
+                continue;
+            }
+            nodes[head].next[int(dir)] = child;
+            if (changes.MovesDropped()) {
+                nodes[head].pushes |= uint8_t(1 << int(dir));
+            }
+            for (const auto& move : changes.Moves()) {
+                if (std::find(youObjects.begin(), youObjects.end(), move.type) ==
+                    youObjects.end()) {
+                    nodes[head].pushes |= uint8_t(1 << int(dir));
+                    break;
+                }
+            }
+        }
+    }
+    result.statesVisited = nodes.size();
+
+    // fewest moves: breadth first from the start, node 0
+    std::vector<std::pair<int32_t, Direction>> parents(nodes.size(), { NO_NODE, Direction::Up });
+    std::vector<uint8_t> seen(nodes.size(), 0);
+    std::vector<int32_t> queue = { 0 };
+    seen[0] = 1;
+    for (size_t q = 0; q < queue.size(); ++q) {
+        const int32_t node = queue[q];
+        if (nodes[node].isWin) {
+            result.shortest = PathTo(parents, node);
+            break;
+        }
+        for (const Direction dir : DIRECTIONS) {
+            const int32_t child = nodes[node].next[int(dir)];
+            if (child != NO_NODE && !seen[child]) {
+                seen[child] = 1;
+                parents[child] = { node, dir };
+                queue.push_back(child);
+            }
+        }
+    }
+
+    // fewest pushes, then fewest moves: Dijkstra on (pushes, moves)
+    using Cost = std::tuple<size_t, size_t, int32_t>;
+    std::vector<std::pair<size_t, size_t>> best(nodes.size(), { SIZE_MAX, SIZE_MAX });
+    std::priority_queue<Cost, std::vector<Cost>, std::greater<>> open;
+    std::fill(parents.begin(), parents.end(), std::pair{ NO_NODE, Direction::Up });
+    best[0] = { 0, 0 };
+    open.emplace(0, 0, 0);
+    while (!open.empty()) {
+        const auto [pushes, moves, node] = open.top();
+        open.pop();
+        if (best[node] != std::pair{ pushes, moves }) {
+            continue;
+        }
+        if (nodes[node].isWin) {
+            result.fewestPushes = PathTo(parents, node);
+            break;
+        }
+        for (const Direction dir : DIRECTIONS) {
+            const int32_t child = nodes[node].next[int(dir)];
+            if (child == NO_NODE) {
+                continue;
+            }
+            const size_t push = (nodes[node].pushes >> int(dir)) & 1;
+            const std::pair<size_t, size_t> cost = { pushes + push, moves + 1 };
+            if (cost < best[child]) {
+                best[child] = cost;
+                parents[child] = { node, dir };
+                open.emplace(cost.first, cost.second, child);
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "engine.h"
+#include <cstddef>
+#include <string>
+#include <span>
+
+namespace BabaIsYou {
+
+struct MinimizerOptions {
+    int radius = 3;               // moves a searched state may stray from the replay's states
+    size_t maxStates = 2'000'000; // the neighbourhood stops growing here
+};
+
+struct MinimizedReplay {
+    bool won = false;         // the replay reaches a win; nothing else is set otherwise
+    std::string shortest;     // fewest moves, W/A/S/D
+    std::string fewestPushes; // fewest pushes, then fewest moves
+    size_t statesVisited = 0;
+};
+
+// Shortens a replay that wins. Rather than solving from scratch, the search is confined to the
+// states within `radius` moves of a state the replay went through, so its cost grows with the
+// replay's length and not with the level's state space. Both results win the level and are never
+// longer, or pushier, than the replay.
+class ReplayMinimizer {
+  public:
+    explicit ReplayMinimizer(const Engine& engine) : m_engine(engine) {}
+
+    // `played` is every state the replay went through after `start`, in order, as
+    // Session::ApplyMoves reports them through BatchOptions::onState, so that undo follows the
+    // session's rules; states after the first win are ignored
+    MinimizedReplay Minimize(const GameState& start, std::span<const GameState> played,
+        const MinimizerOptions& options) const;
+
+  private:
+    const Engine& m_engine;
+};
+
+} // namespace BabaIsYou
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace BabaIsYou {
+
+// Fixed-capacity single-producer ring buffer. Push never blocks or allocates; once full, the
+// oldest entry is overwritten. Readers index from the oldest retained entry.
+template <typename T, size_t N>
+class RingBuffer {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+  public:
+    void Push(const T& value) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        m_data[head & (N - 1)] = value;
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    size_t Size() const { return std::min(m_head.load(std::memory_order_acquire), N); }
+    size_t Capacity() const { return N; }
+    bool IsEmpty() const { return Size() == 0; }
+
+    // 0 is the oldest retained entry, Size() - 1 the newest
+    const T& operator[](size_t i) const {
+        const size_t head = m_head.load(std::memory_order_acquire);
+        const size_t start = head - std::min(head, N);
+        return m_data[(start + i) & (N - 1)];
+    }
+
+    const T& Back() const { return (*this)[Size() - 1]; }
+
+  private:
+    std::array<T, N> m_data{};
+    std::atomic<size_t> m_head = 0;
+};
+
+} // namespace BabaIsYou
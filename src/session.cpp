@@ -0,0 +1,397 @@
+#include "session.h"
+#include "trace.h"
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+namespace BabaIsYou {
+
+// Session snapshot layout, all integers little-endian:
+//   u32 magic, u16 version, u16 level index
+//   u16 per Property: mask of the object types that have it
+//   state: the current state, as its non-empty tiles
+//   u16 history count, then that many states from newest to oldest, each as the tiles that
+//   differ from the state after it
+// where a state is
+//   u8 win flag, u16 number of tiles, then per tile in index order:
+//   u16 tile index, u8 object count, u8 type per object from bottom to top
+// Consecutive history entries are usually one move apart, so the deltas stay a few tiles each.
+namespace {
+
+class ByteWriter {
+  public:
+    explicit ByteWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    void U8(uint8_t value) { m_out.push_back(value); }
+    void U16(uint16_t value) {
+        m_out.push_back(uint8_t(value));
+        m_out.push_back(uint8_t(value >> 8));
+    }
+    void U32(uint32_t value) {
+        U16(uint16_t(value));
+        U16(uint16_t(value >> 16));
+    }
+    size_t Size() const { return m_out.size(); }
+    void PatchU16(size_t at, uint16_t value) {
+        m_out[at] = uint8_t(value);
+        m_out[at + 1] = uint8_t(value >> 8);
+    }
+
+  private:
+    std::vector<uint8_t>& m_out;
+};
+
+// Reads past the end fail once and stay failed, so callers check Ok() after a group of reads
+class ByteReader {
+  public:
+    explicit ByteReader(std::span<const uint8_t> data) : m_data(data) {}
+
+    uint8_t U8() {
+        if (m_pos + 1 > m_data.size()) {
+            m_ok = false;
+            return 0;
+        }
+        return m_data[m_pos++];
+    }
+    uint16_t U16() {
+        const uint16_t lo = U8();
+        return uint16_t(lo | (U8() << 8));
+    }
+    uint32_t U32() {
+        const uint32_t lo = U16();
+        return lo | (uint32_t(U16()) << 16);
+    }
+    bool Ok() const { return m_ok; }
+    bool AtEnd() const { return m_pos == m_data.size(); }
+
+  private:
+    std::span<const uint8_t> m_data;
+    size_t m_pos = 0;
+    bool m_ok = true;
+};
+
+bool SameTile(const TileObjects& a, const TileObjects& b) {
+    if (a.Size() != b.Size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.Size(); ++i) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Writes the tiles of `gs` that differ from `base`, or its non-empty tiles without a base
+void WriteState(ByteWriter& out, const GameState& gs, const GameState* base) {
+    TRACE_ZONE("Session::WriteState");
+
+    out.U8(gs.IsWin() ? 1 : 0);
+    const size_t countAt = out.Size();
+    out.U16(0);
+
+    uint16_t numTiles = 0;
+    for (int y = 0; y < LEVEL_HEIGHT; ++y) {
+        for (int x = 0; x < LEVEL_WIDTH; ++x) {
+            const TileObjects tile = gs.At(x, y);
+            if (base ? SameTile(tile, base->At(x, y)) : tile.IsEmpty()) {
+                continue;
+            }
+            out.U16(ToIndex(x, y));
+            out.U8(uint8_t(tile.Size()));
+            for (const auto obj : tile) {
+                out.U8(uint8_t(obj));
+            }
+            numTiles++;
+        }
+    }
+    out.PatchU16(countAt, numTiles);
+}
+
+// Replaces the listed tiles of `gs`, the inverse of WriteState over the same base
+bool ReadState(ByteReader& in, GameState& gs) {
+    const uint8_t isWin = in.U8();
+    const uint16_t numTiles = in.U16();
+    for (uint16_t i = 0; i < numTiles && in.Ok(); ++i) {
+        const uint16_t index = in.U16();
+        const uint8_t count = in.U8();
+        if (index >= NUM_TILES) {
+            return false;
+        }
+
+        const auto [x, y] = ToPos(index);
+        while (!gs.At(x, y).IsEmpty()) {
+            gs.Remove(x, y, gs.At(x, y).Top());
+        }
+        for (uint8_t k = 0; k < count; ++k) {
+            const uint8_t type = in.U8();
+            if (type == uint8_t(ObjectType::Empty) || type >= NUM_OBJECT_TYPES) {
+                return false;
+            }
+            if (!gs.Push(x, y, ObjectType(type))) {
+                return false;
+            }
+        }
+    }
+    gs.SetWin(isWin != 0);
+    return in.Ok() && isWin <= 1;
+}
+
+} // namespace
+
+Session::Session() {
+    m_levelManager.LoadLevel(m_currentState);
+    // the history and the current state are the most states a session keeps alive, so once
+    // their blocks are pooled, turns recycle them and never reach the heap
+    m_currentState.ReservePool(MAX_HISTORY + 1);
+    Reset();
+}
+
+void Session::LoadLevel() {
+    m_levelManager.LoadLevel(m_currentState);
+    Reset();
+}
+
+void Session::NextLevel() {
+    m_levelManager.NextLevel(m_currentState);
+    Reset();
+}
+
+void Session::PreviousLevel() {
+    m_levelManager.PreviousLevel(m_currentState);
+    Reset();
+}
+
+bool Session::SelectLevel(int index) {
+    if (!m_levelManager.SelectLevel(index, m_currentState)) {
+        return false;
+    }
+    Reset();
+    return true;
+}
+
+bool Session::SelectLevel(int index, GameState& prepared) {
+    if (!m_levelManager.SetCurrentIndex(index)) {
+        return false;
+    }
+    std::swap(m_currentState, prepared);
+    Reset();
+    return true;
+}
+
+bool Session::TryMove(Direction dir) {
+    TRACE_ZONE("Session::TryMove");
+
+    if (!m_engine.HasYou(m_currentState)) {
+        return false;
+    }
+
+    SaveState();
+    m_lastChanges.Clear();
+    m_engine.Step(m_currentState, dir, &m_lastChanges);
+    return true;
+}
+
+BatchResult Session::ApplyMoves(std::string_view moves, const BatchOptions& options) {
+    TRACE_ZONE("Session::ApplyMoves");
+
+    BatchResult result;
+    for (size_t i = 0; i < moves.size(); ++i) {
+        Direction dir;
+        if (!IsUndoMove(moves[i]) && !FromChar(moves[i], dir)) {
+            result.valid = false;
+            result.applied = i;
+            return result;
+        }
+    }
+
+    bool batchSaved = false;
+    for (const char move : moves) {
+        if (options.stopOnWin && m_currentState.IsWin()) {
+            break;
+        }
+
+        Direction dir;
+        if (IsUndoMove(move)) {
+            Undo();
+            batchSaved = false;
+        } else if (FromChar(move, dir) && m_engine.HasYou(m_currentState)) {
+            if (options.historyPerStep || !batchSaved) {
+                SaveState();
+                batchSaved = true;
+            }
+            m_lastChanges.Clear();
+            m_engine.Step(m_currentState, dir, &m_lastChanges);
+        }
+        result.applied++;
+        if (options.onState) {
+            options.onState(m_currentState);
+        }
+    }
+
+    result.won = m_currentState.IsWin();
+    return result;
+}
+
+void EncodeSession(const SessionSnapshot& snapshot, std::vector<uint8_t>& out) {
+    TRACE_ZONE("EncodeSession");
+
+    out.clear();
+    ByteWriter writer(out);
+    writer.U32(SESSION_MAGIC);
+    writer.U16(SESSION_VERSION);
+    writer.U16(uint16_t(snapshot.level));
+    for (const uint16_t mask : snapshot.rules) {
+        writer.U16(mask);
+    }
+
+    WriteState(writer, snapshot.current, nullptr);
+    writer.U16(uint16_t(snapshot.historyCount));
+    const GameState* after = &snapshot.current;
+    for (size_t i = snapshot.historyCount; i-- > 0;) {
+        WriteState(writer, snapshot.history[i], after);
+        after = &snapshot.history[i];
+    }
+}
+
+void Session::Save(std::vector<uint8_t>& out) const {
+    const auto snapshot = std::make_unique<SessionSnapshot>();
+    Snapshot(*snapshot);
+    EncodeSession(*snapshot, out);
+}
+
+void Session::Snapshot(SessionSnapshot& out) const {
+    TRACE_ZONE("Session::Snapshot");
+
+    out.level = m_levelManager.CurrentIndex();
+    for (int property = 0; property < SESSION_PROPERTIES; ++property) {
+        uint16_t mask = 0;
+        for (const auto type : m_engine.GetRules().Get(Property(property))) {
+            mask |= uint16_t(1u << int(type));
+        }
+        out.rules[size_t(property)] = mask;
+    }
+
+    out.current = m_currentState;
+    for (size_t i = 0; i < m_historyCount; ++i) {
+        out.history[i] = m_history[(m_historyStart + i) % MAX_HISTORY];
+    }
+    for (size_t i = m_historyCount; i < out.historyCount; ++i) {
+        out.history[i] = GameState(); // a reused snapshot drops states the session let go
+    }
+    out.historyCount = m_historyCount;
+}
+
+bool Session::Restore(std::span<const uint8_t> data) {
+    TRACE_ZONE("Session::Restore");
+
+    ByteReader reader(data);
+    if (reader.U32() != SESSION_MAGIC || reader.U16() != SESSION_VERSION) {
+        return false;
+    }
+    const int level = reader.U16();
+    if (!reader.Ok() || level >= m_levelManager.Count()) {
+        return false;
+    }
+
+    Engine engine;
+    for (int property = 0; property < SESSION_PROPERTIES; ++property) {
+        const uint16_t mask = reader.U16();
+        for (ObjectType type = ObjectType::Empty; type < ObjectType::NumType; ++type) {
+            if (mask & (1u << int(type))) {
+                engine.AddRule(type, Property(property));
+            } else {
+                engine.RemoveRule(type, Property(property));
+            }
+        }
+    }
+
+    GameState state;
+    if (!ReadState(reader, state)) {
+        return false;
+    }
+
+    // the history is decoded in place, so from here a failure has to drop it
+    const size_t historyCount = reader.U16();
+    bool ok = reader.Ok() && historyCount <= MAX_HISTORY;
+    const GameState* after = &state;
+    for (size_t i = historyCount; ok && i-- > 0;) {
+        m_history[i] = *after;
+        ok = ReadState(reader, m_history[i]);
+        after = &m_history[i];
+    }
+    if (!ok || !reader.AtEnd()) {
+        Reset();
+        return false;
+    }
+
+    m_levelManager.SelectLevel(level, m_currentState);
+    m_currentState = state;
+    m_engine = engine;
+    m_sharedEngine.reset();
+    m_lastChanges.Clear();
+    m_historyStart = 0;
+    m_historyCount = historyCount;
+    return true;
+}
+
+std::shared_ptr<const Engine> Session::ShareEngine() const {
+    if (!m_sharedEngine) {
+        m_sharedEngine = std::make_shared<const Engine>(m_engine);
+    }
+    return m_sharedEngine;
+}
+
+void Session::AddRule(ObjectType type, Property property) {
+    m_engine.AddRule(type, property);
+    m_sharedEngine.reset();
+    m_currentState.SetWin(m_engine.CheckWin(m_currentState));
+}
+
+void Session::RemoveRule(ObjectType type, Property property) {
+    m_engine.RemoveRule(type, property);
+    m_sharedEngine.reset();
+    m_currentState.SetWin(m_engine.CheckWin(m_currentState));
+}
+
+void Session::Reset() {
+    m_lastChanges.Clear();
+    m_historyStart = 0;
+    m_historyCount = 0;
+    SaveState();
+}
+
+void Session::SaveState() {
+    TRACE_ZONE("Session::SaveState");
+
+    size_t index = (m_historyStart + m_historyCount) % MAX_HISTORY;
+
+    m_history[index] = m_currentState;
+
+    if (m_historyCount < MAX_HISTORY) {
+        m_historyCount++;
+    } else {
+        m_historyStart = (m_historyStart + 1) % MAX_HISTORY;
+    }
+}
+
+void Session::LoadState(const GameState& gs) {
+    m_currentState = gs;
+    // the rules may have changed since `gs` was saved, and Step trusts the flag it comes in with
+    m_currentState.SetWin(m_engine.CheckWin(m_currentState));
+    m_lastChanges.Clear();
+}
+
+void Session::Undo() {
+    if (m_historyCount == 0) {
+        return;
+    }
+
+    size_t index = (m_historyStart + m_historyCount - 1) % MAX_HISTORY;
+
+    LoadState(m_history[index]);
+
+    m_historyCount--;
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "engine.h"
+#include "level.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace BabaIsYou {
+
+constexpr size_t MAX_HISTORY = 512;
+constexpr char UNDO_MOVE = 'X';
+constexpr uint32_t SESSION_MAGIC = 0x53424142; // "BABS"
+constexpr uint16_t SESSION_VERSION = 1;
+
+// Like FromChar, either case
+constexpr bool IsUndoMove(char c) {
+    return c == UNDO_MOVE || c == 'x';
+}
+
+struct BatchOptions {
+    bool historyPerStep = true; // false: the whole batch is a single undo step
+    bool stopOnWin = true;
+
+    // Called with the current state after every move or undo the batch consumes
+    std::function<void(const GameState&)> onState;
+};
+
+struct BatchResult {
+    size_t applied = 0; // moves consumed from the string
+    bool won = false;
+    bool valid = true; // false: nothing was applied, `applied` is the offending position
+};
+
+constexpr int SESSION_PROPERTIES = 4; // properties a snapshot keeps the rules of, You to Push
+
+// What Session::Save writes, with the states as forks of the session's own. Taking one costs a few
+// reference counts per state, so the encoding can run on another thread.
+struct SessionSnapshot {
+    int level = 0;
+    std::array<uint16_t, SESSION_PROPERTIES> rules{}; // per Property, a bit per type that has it
+    GameState current;
+    std::array<GameState, MAX_HISTORY> history; // oldest first
+    size_t historyCount = 0;
+};
+
+// Encodes a snapshot in the layout Session::Restore reads
+void EncodeSession(const SessionSnapshot& snapshot, std::vector<uint8_t>& out);
+
+// One player's run through the levels: the current state, its undo history and the level
+// selection. Headless; the game window and the command line tool both drive it.
+class Session {
+  public:
+    Session();
+
+    void LoadLevel();
+    void NextLevel();
+    void PreviousLevel();
+    bool SelectLevel(int index);
+
+    // Switches to level `index` using `prepared`, a state already built from it, instead of
+    // building it here. The previous state is handed back in `prepared`.
+    bool SelectLevel(int index, GameState& prepared);
+
+    bool TryMove(Direction dir);
+    void Undo();
+
+    // Plays a move string (W/A/S/D, X undoes) in one call
+    BatchResult ApplyMoves(std::string_view moves, const BatchOptions& options = {});
+
+    // Binary snapshot of the level index, rules, current state and undo history; the layout is
+    // described in session.cpp. Restore returns false on a malformed snapshot, one from another
+    // version, or one whose level index is out of range for the current levels. A snapshot does
+    // not say which level set it came from, so one saved with other levels is only caught by
+    // that index check. On false the current level and state are kept; the undo history is
+    // dropped when the failure was in the history.
+    void Save(std::vector<uint8_t>& out) const;
+    // The first half of Save; EncodeSession is the rest
+    void Snapshot(SessionSnapshot& out) const;
+    bool Restore(std::span<const uint8_t> data);
+
+    void AddRule(ObjectType type, Property property);
+    void RemoveRule(ObjectType type, Property property);
+
+    const GameState& GetState() const { return m_currentState; }
+
+    // What the last move changed; empty after anything other than a move
+    const ChangeSet& GetLastChanges() const { return m_lastChanges; }
+    const Engine& GetEngine() const { return m_engine; }
+    // An immutable copy of the engine for other threads; the copy is made once per rule change
+    // and shared by every call until the next one
+    std::shared_ptr<const Engine> ShareEngine() const;
+    LevelManager& GetLevels() { return m_levelManager; }
+    const LevelManager& GetLevels() const { return m_levelManager; }
+
+  private:
+    void Reset();
+
+    void SaveState();
+    void LoadState(const GameState& gs);
+
+    GameState m_currentState;
+    ChangeSet m_lastChanges;
+    LevelManager m_levelManager;
+    Engine m_engine;
+    mutable std::shared_ptr<const Engine> m_sharedEngine; // null when the rules changed since
+
+    std::array<GameState, MAX_HISTORY> m_history;
+    size_t m_historyStart = 0; // oldest saved
+    size_t m_historyCount = 0; // how many valid snapshots
+};
+
+} // namespace BabaIsYou
@@ -0,0 +1,76 @@
+#include "session_file.h"
+#include "trace.h"
+#include <fstream>
+#include <utility>
+
+namespace BabaIsYou {
+
+bool ReadSessionFile(const std::filesystem::path& path, std::vector<uint8_t>& out) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    out.resize(size_t(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(out.data()), std::streamsize(out.size()));
+    return bool(file);
+}
+
+SessionWriter::SessionWriter(std::filesystem::path path)
+    : m_path(std::move(path)), m_thread(&SessionWriter::Run, this) {}
+
+SessionWriter::~SessionWriter() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void SessionWriter::Submit(std::unique_ptr<SessionSnapshot>& snapshot) {
+    {
+        std::lock_guard lock(m_mutex);
+        m_pending.swap(snapshot);
+        m_hasPending = true;
+    }
+    m_wake.notify_one();
+}
+
+void SessionWriter::Run() {
+    auto snapshot = std::make_unique<SessionSnapshot>();
+    std::vector<uint8_t> data; // reused, so it stops allocating once grown
+    for (;;) {
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_hasPending || m_stop; });
+            if (!m_hasPending) {
+                return;
+            }
+            snapshot.swap(m_pending);
+            m_hasPending = false;
+        }
+        EncodeSession(*snapshot, data);
+        Write(data);
+    }
+}
+
+bool SessionWriter::Write(const std::vector<uint8_t>& data) const {
+    TRACE_ZONE("SessionWriter::Write");
+
+    std::filesystem::path temp = m_path;
+    temp += ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+        if (!file) {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp, m_path, error);
+    return !error;
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "session.h"
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BabaIsYou {
+
+bool ReadSessionFile(const std::filesystem::path& path, std::vector<uint8_t>& out);
+
+// Encodes session snapshots and writes them to disk on a background thread, so the frame only
+// takes the snapshot and never waits on the encoding or the file system. When snapshots arrive
+// faster than the disk takes them, only the newest is written. A snapshot goes to a temporary
+// file that is then renamed over the target, so a crash mid-write leaves the previous one intact.
+//
+// The writer holds on to the forks of a snapshot it has written until Submit hands it back, so
+// the states' blocks are released on the submitting thread and return to its block pool.
+class SessionWriter {
+  public:
+    explicit SessionWriter(std::filesystem::path path);
+    ~SessionWriter(); // writes the pending snapshot, if any, before returning
+
+    SessionWriter(const SessionWriter&) = delete;
+    SessionWriter& operator=(const SessionWriter&) = delete;
+
+    // Takes `snapshot` and hands back a spare one in its place, for the caller to fill next
+    void Submit(std::unique_ptr<SessionSnapshot>& snapshot);
+
+  private:
+    void Run();
+    bool Write(const std::vector<uint8_t>& data) const;
+
+    std::filesystem::path m_path;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::unique_ptr<SessionSnapshot> m_pending = std::make_unique<SessionSnapshot>();
+    bool m_hasPending = false;
+    bool m_stop = false;
+
+    std::thread m_thread; // last, so it starts after everything it uses
+};
+
+} // namespace BabaIsYou
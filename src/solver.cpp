@@ -0,0 +1,399 @@
+#include "solver.h"
+#include "compact_key.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace BabaIsYou {
+
+namespace {
+
+constexpr int32_t NO_NODE = -1;
+
+struct Node {
+    int32_t parent; // forward: the state before; backward: the state `move` leads to
+    Direction move;
+};
+
+// One direction of the search. Nodes are appended in search order, so the unexpanded ones,
+// [head, nodes.size()), are the frontier. A node's number is that of its key in `visited`.
+struct Side {
+    explicit Side(size_t words) : visited(words) {}
+
+    std::vector<Node> nodes;
+    CompactKeySet visited;
+    size_t head = 0;
+
+    size_t Frontier() const { return nodes.size() - head; }
+
+    // Returns false if `key` was already visited
+    bool Add(std::span<const uint64_t> key, int32_t parent, Direction move) {
+        if (!visited.Insert(key).second) {
+            return false;
+        }
+        nodes.push_back({ parent, move });
+        return true;
+    }
+
+    int32_t Find(std::span<const uint64_t> key) const { return visited.Find(key); }
+};
+
+bool Contains(const std::vector<ObjectType>& types, ObjectType type) {
+    return std::find(types.begin(), types.end(), type) != types.end();
+}
+
+// Moves from the start to forward node `node`
+std::string ForwardPath(const Side& forward, int32_t node) {
+    std::string moves;
+    for (; forward.nodes[node].parent != NO_NODE; node = forward.nodes[node].parent) {
+        moves.push_back(ToChar(forward.nodes[node].move));
+    }
+    std::reverse(moves.begin(), moves.end());
+    return moves;
+}
+
+// Moves from backward node `node` to the won state it was seeded from
+void AppendBackwardPath(const Side& backward, int32_t node, std::string& moves) {
+    for (; backward.nodes[node].parent != NO_NODE; node = backward.nodes[node].parent) {
+        moves.push_back(ToChar(backward.nodes[node].move));
+    }
+}
+
+} // namespace
+
+size_t CountPushes(const Engine& engine, const GameState& start, std::string_view moves) {
+    const auto& youObjects = engine.GetRules().Get(Property::You);
+    GameState state = start;
+    ChangeSet changes;
+    size_t pushes = 0;
+    for (const char c : moves) {
+        Direction dir;
+        if (!FromChar(c, dir)) {
+            continue;
+        }
+        changes.Clear();
+        engine.Step(state, dir, &changes);
+        if (changes.MovesDropped()) {
+            pushes++; // only a You that is also Push overflows the moves, by pushing
+            continue;
+        }
+        for (const auto& move : changes.Moves()) {
+            if (std::find(youObjects.begin(), youObjects.end(), move.type) == youObjects.end()) {
+                pushes++;
+                break;
+            }
+        }
+    }
+    return pushes;
+}
+
+SolverResult Solver::Solve(const GameState& start, const SolverOptions& options) const {
+    if (options.bidirectional && !start.IsWin() && CanPull(start)) {
+        return SolveBidirectional(start, options);
+    }
+    if (!options.externalDir.empty()) {
+        return SolveExternal(start, options);
+    }
+    return SolveBfs(start, options);
+}
+
+SolverResult Solver::SolveBfs(const GameState& start, const SolverOptions& options) const {
+    SolverResult result;
+    if (start.IsWin()) {
+        result.solved = true;
+        return result;
+    }
+
+    // keys are built in a scratch buffer and copied into the set only for a new state
+    const CompactKeyCodec codec(m_engine, start);
+    CompactKeySet visited(codec.Words());
+    std::vector<Node> nodes; // node i has key i in `visited`
+    std::vector<uint64_t> key(codec.Words());
+    codec.Encode(start, key);
+    visited.Insert(key);
+    nodes.push_back({ -1, Direction::Up });
+
+    auto path = [&nodes](int32_t node, Direction last) {
+        std::string moves(1, ToChar(last));
+        for (; nodes[node].parent >= 0; node = nodes[node].parent) {
+            moves.push_back(ToChar(nodes[node].move));
+        }
+        std::reverse(moves.begin(), moves.end());
+        return moves;
+    };
+
+    GameState state;
+    GameState next;
+    for (size_t head = 0; head < nodes.size(); ++head) {
+        if (options.cancel && options.cancel->load(std::memory_order_relaxed)) {
+            result.statesVisited = visited.Size();
+            return result;
+        }
+        codec.Decode(visited.Key(int32_t(head)), state);
+
+        for (const Direction dir : DIRECTIONS) {
+            next = state;
+            if (!m_engine.Step(next, dir)) {
+                result.statesVisited = visited.Size();
+                result.exhausted = true;
+                return result;
+            }
+
+            if (next.IsWin()) {
+                result.solved = true;
+                result.moves = path(int32_t(head), dir);
+                result.statesVisited = visited.Size();
+                return result;
+            }
+
+            codec.Encode(next, key);
+            if (!visited.Insert(key).second) {
+                continue;
+            }
+            nodes.push_back({ int32_t(head), dir });
+            if (visited.Size() >= options.maxStates) {
+                result.statesVisited = visited.Size();
+                return result;
+            }
+        }
+    }
+
+    result.statesVisited = visited.Size();
+    result.exhausted = true;
+    return result;
+}
+
+bool Solver::CanPull(const GameState& start) const {
+    const auto& rules = m_engine.GetRules();
+    const auto& pushObjects = rules.Get(Property::Push);
+    size_t numYous = 0;
+    for (const auto type : rules.Get(Property::You)) {
+        if (Contains(pushObjects, type)) {
+            return false;
+        }
+        numYous += start.Count(type);
+    }
+    for (const auto type : rules.Get(Property::Stop)) {
+        if (Contains(pushObjects, type)) {
+            return false;
+        }
+    }
+    return numYous == 1;
+}
+
+// With the You at n after moving in direction d, it came from p = n - d. Tile n held no Push
+// object, or the chain of Push tiles n, n + d, ..., n + (k - 1)d moved on by one, each tile's
+// Push objects as a whole. So every k from 0 up to the run of Push tiles past n gives one
+// predecessor, as long as the tile the chain ended on, n + kd, has no Stop.
+template <typename Visit>
+void Solver::ForEachPull(const GameState& after, GameState& before, Visit&& visit) const {
+    const auto& rules = m_engine.GetRules();
+    const auto& pushObjects = rules.Get(Property::Push);
+    const auto& stopObjects = rules.Get(Property::Stop);
+
+    ObjectType you = ObjectType::NumType;
+    Vec2i n{};
+    for (const auto type : rules.Get(Property::You)) {
+        if (after.Count(type) > 0) {
+            you = type;
+            n = ToPos(after.Positions(type)[0]);
+            break;
+        }
+    }
+    if (you == ObjectType::NumType) {
+        return;
+    }
+    auto inBounds = [](int x, int y) {
+        return x >= 0 && x < LEVEL_WIDTH && y >= 0 && y < LEVEL_HEIGHT;
+    };
+    if (after.At(n.x, n.y).Contains(pushObjects) || after.At(n.x, n.y).Contains(stopObjects)) {
+        return;
+    }
+
+    for (const Direction dir : DIRECTIONS) {
+        const auto [dx, dy] = ToDelta(dir);
+        const Vec2i p = { n.x - dx, n.y - dy };
+        if (!inBounds(p.x, p.y)) {
+            continue;
+        }
+
+        int run = 0;
+        while (inBounds(n.x + (run + 1) * dx, n.y + (run + 1) * dy) &&
+            after.At(n.x + (run + 1) * dx, n.y + (run + 1) * dy).Contains(pushObjects)) {
+            run++;
+        }
+
+        for (int k = 0; k <= run; ++k) {
+            if (k > 0 && after.At(n.x + k * dx, n.y + k * dy).Contains(stopObjects)) {
+                continue;
+            }
+            before = after;
+            before.Move(n.x, n.y, p.x, p.y, you);
+            for (int i = 1; i <= k; ++i) {
+                const int fromX = n.x + i * dx;
+                const int fromY = n.y + i * dy;
+                std::array<ObjectType, MAX_STACK_HEIGHT> pulled;
+                int numPulled = 0;
+                for (const auto obj : before.At(fromX, fromY)) {
+                    if (Contains(pushObjects, obj)) {
+                        pulled[numPulled++] = obj;
+                    }
+                }
+                for (int j = 0; j < numPulled; ++j) {
+                    before.Move(fromX, fromY, fromX - dx, fromY - dy, pulled[j]);
+                }
+            }
+            before.SetWin(m_engine.CheckWin(before));
+            if (!before.IsWin()) {
+                visit(before, dir);
+            }
+        }
+    }
+}
+
+SolverResult Solver::SolveBidirectional(
+    const GameState& start, const SolverOptions& options) const {
+    const auto& rules = m_engine.GetRules();
+    const auto& youObjects = rules.Get(Property::You);
+    const auto& pushObjects = rules.Get(Property::Push);
+    const auto& stopObjects = rules.Get(Property::Stop);
+
+    SolverResult result;
+    const CompactKeyCodec codec(m_engine, start);
+    Side forward(codec.Words());
+    Side backward(codec.Words());
+    auto numStates = [&] { return forward.visited.Size() + backward.visited.Size(); };
+
+    std::vector<uint64_t> key(codec.Words());
+    codec.Encode(start, key);
+    forward.Add(key, NO_NODE, Direction::Up);
+
+    // Adds the won states that differ from `gs` only by where the You is. Backward nodes never
+    // hold a forward state, a forward state is never won, so a seed cannot meet right away.
+    GameState goal;
+    auto seed = [&](const GameState& gs) {
+        ObjectType you = ObjectType::NumType;
+        Vec2i from{};
+        for (const auto type : youObjects) {
+            if (gs.Count(type) > 0) {
+                you = type;
+                from = ToPos(gs.Positions(type)[0]);
+            }
+        }
+        for (const auto winType : rules.Get(Property::Win)) {
+            for (const auto index : gs.Positions(winType)) {
+                const auto [x, y] = ToPos(index);
+                // the You only ever ends a move on a tile without Push or Stop
+                if (gs.At(x, y).Contains(pushObjects) || gs.At(x, y).Contains(stopObjects)) {
+                    continue;
+                }
+                goal = gs;
+                goal.Move(from.x, from.y, x, y, you);
+                codec.Encode(goal, key);
+                backward.Add(key, NO_NODE, Direction::Up);
+            }
+        }
+    };
+    seed(start);
+
+    auto finish = [&](bool exhausted) {
+        result.statesVisited = numStates();
+        result.exhausted = exhausted;
+        return result;
+    };
+
+    GameState state;
+    GameState next;
+    ChangeSet changes;
+    auto cancelled = [&] {
+        return options.cancel && options.cancel->load(std::memory_order_relaxed);
+    };
+    while (forward.Frontier() > 0) {
+        // grow the smaller frontier by one layer
+        if (backward.Frontier() > 0 && backward.Frontier() < forward.Frontier()) {
+            const size_t end = backward.nodes.size();
+            for (; backward.head < end; ++backward.head) {
+                if (cancelled()) {
+                    return finish(false);
+                }
+                const int32_t head = int32_t(backward.head);
+                codec.Decode(backward.visited.Key(head), state);
+                int32_t met = NO_NODE;
+                Direction metDir = Direction::Up;
+                ForEachPull(state, next, [&](const GameState& before, Direction dir) {
+                    if (met != NO_NODE) {
+                        return;
+                    }
+                    codec.Encode(before, key);
+                    if (const int32_t node = forward.Find(key); node != NO_NODE) {
+                        met = node;
+                        metDir = dir;
+                        return;
+                    }
+                    backward.Add(key, head, dir);
+                });
+                if (met != NO_NODE) {
+                    result.solved = true;
+                    result.moves = ForwardPath(forward, met);
+                    result.moves.push_back(ToChar(metDir));
+                    AppendBackwardPath(backward, head, result.moves);
+                    return finish(false);
+                }
+                if (numStates() >= options.maxStates) {
+                    return finish(false);
+                }
+            }
+            continue;
+        }
+
+        const size_t end = forward.nodes.size();
+        for (; forward.head < end; ++forward.head) {
+            if (cancelled()) {
+                return finish(false);
+            }
+            const int32_t head = int32_t(forward.head);
+            codec.Decode(forward.visited.Key(head), state);
+
+            for (const Direction dir : DIRECTIONS) {
+                next = state;
+                changes.Clear();
+                if (!m_engine.Step(next, dir, &changes)) {
+                    return finish(true);
+                }
+
+                if (next.IsWin()) {
+                    result.solved = true;
+                    result.moves = ForwardPath(forward, head);
+                    result.moves.push_back(ToChar(dir));
+                    return finish(false);
+                }
+
+                codec.Encode(next, key);
+                if (const int32_t node = backward.Find(key); node != NO_NODE) {
+                    result.solved = true;
+                    result.moves = ForwardPath(forward, head);
+                    result.moves.push_back(ToChar(dir));
+                    AppendBackwardPath(backward, node, result.moves);
+                    return finish(false);
+                }
+                if (!forward.Add(key, head, dir)) {
+                    continue;
+                }
+
+                const auto& moved = changes.Moves();
+                if (std::any_of(moved.begin(), moved.end(),
+                        [&](const auto& move) { return !Contains(youObjects, move.type); })) {
+                    seed(next);
+                }
+                if (numStates() >= options.maxStates) {
+                    return finish(false);
+                }
+            }
+        }
+    }
+    return finish(true);
+}
+
+} // namespace BabaIsYou
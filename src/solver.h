@@ -0,0 +1,74 @@
+#pragma once
+
+#include "engine.h"
+#include "level.h"
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace BabaIsYou {
+
+struct SolverOptions {
+    size_t maxStates = 2'000'000; // give up after visiting this many distinct states
+    const std::atomic<bool>* cancel = nullptr; // give up as soon as this is set
+
+    // Also search backward from won states with pull moves, meeting the forward search in the
+    // middle. Only for levels with a single You that is not pushable, and rules where nothing is
+    // both Push and Stop; others fall back to the plain search. The solution found is not always
+    // a shortest one.
+    bool bidirectional = false;
+
+    // When set, search breadth first with the layers on disk in this directory, for state spaces
+    // larger than memory. Expects a directory of its own; the files are removed afterwards.
+    // Ignored when bidirectional applies.
+    std::filesystem::path externalDir;
+    size_t externalMemory = size_t(256) << 20; // bytes of successors sorted in memory per run
+};
+
+struct SolverResult {
+    bool solved = false;
+    bool exhausted = false; // the whole reachable space was searched without a win
+    bool failed = false;    // the external mode could not use its directory
+    std::string moves;      // W/A/S/D, shortest first found unless bidirectional
+    size_t statesVisited = 0;
+};
+
+// Number of moves in `moves`, played from `start`, that push an object other than a You; moves
+// are W/A/S/D as in SolverResult
+size_t CountPushes(const Engine& engine, const GameState& start, std::string_view moves);
+
+// Breadth-first search for the shortest move sequence that reaches a win.
+//
+// The bidirectional mode seeds the backward search lazily: a won state is the You on a Win tile,
+// with the rest of the board as the forward search left it after a push, or as at the start.
+// Every pull undoes one move, so a meeting state links a forward path to a won state.
+//
+// The external mode keeps no state in memory beyond one sorted run and the read buffers of a
+// merge. Each layer is a file of compact keys sorted by hash and key, with the hash of their
+// parent; successors of a layer are sorted in runs, and one streaming merge of the runs with the
+// sorted keys of all earlier states drops duplicates and writes the next layer. States are told
+// apart by their full keys. A solution is read back through the parent hashes, one pass per layer,
+// replaying the move from each state with the parent's hash to find the one that leads on.
+class Solver {
+  public:
+    explicit Solver(const Engine& engine) : m_engine(engine) {}
+
+    SolverResult Solve(const GameState& start, const SolverOptions& options = {}) const;
+
+  private:
+    SolverResult SolveBfs(const GameState& start, const SolverOptions& options) const;
+    SolverResult SolveBidirectional(const GameState& start, const SolverOptions& options) const;
+    SolverResult SolveExternal(const GameState& start, const SolverOptions& options) const;
+    bool CanPull(const GameState& start) const;
+
+    // Calls visit(before, dir) for every state `before`, not won, with Step(before, dir) ==
+    // `after`; `before` is scratch reused between calls
+    template <typename Visit>
+    void ForEachPull(const GameState& after, GameState& before, Visit&& visit) const;
+
+    const Engine& m_engine;
+};
+
+} // namespace BabaIsYou
@@ -0,0 +1,135 @@
+#include "solver.h"
+#include "compact_key.h"
+#include "external_sort.h"
+#include "trace.h"
+#include <algorithm>
+#include <string>
+
+// Disk-backed breadth-first search for Solver::SolveExternal, on the sorted runs of
+// external_sort.h
+namespace BabaIsYou {
+
+SolverResult Solver::SolveExternal(const GameState& start, const SolverOptions& options) const {
+    TRACE_ZONE("Solver::SolveExternal");
+
+    SolverResult result;
+    if (start.IsWin()) {
+        result.solved = true;
+        return result;
+    }
+
+    auto failed = [&] {
+        result.failed = true;
+        return result;
+    };
+    SearchFiles files(options.externalDir);
+    if (!files.Open()) {
+        return failed();
+    }
+
+    const CompactKeyCodec codec(m_engine, start);
+    StateRecord record;
+    record.key.resize(codec.Words());
+    codec.Encode(start, record.key);
+    record.hash = HashCompactKey(record.key);
+    record.parent = record.hash;
+    {
+        RunWriter layer(files.Layer(0));
+        layer.Write(record);
+        RunWriter visited(files.Visited(0));
+        visited.WriteKey(record);
+        if (!layer.Close() || !visited.Close()) {
+            return failed();
+        }
+    }
+    size_t numStates = 1;
+    result.statesVisited = numStates;
+
+    GameState state;
+    GameState next;
+    std::vector<uint64_t> key(codec.Words());
+
+    // Moves from the start to `record`, a state of layer `depth`. Its parent is the state of the
+    // layer before with the parent hash that `record.move` takes to `record`; layers are sorted
+    // by hash, so each is read up to the parent's hash only.
+    auto path = [&](StateRecord record, size_t depth) {
+        std::string moves;
+        for (; depth > 0; --depth) {
+            moves.push_back(ToChar(record.move));
+            const StateRecord child = record;
+            RunReader layer(files.Layer(depth - 1));
+            while (layer.Read(record) && record.hash <= child.parent) {
+                if (record.hash != child.parent) {
+                    continue;
+                }
+                codec.Decode(record.key, state);
+                m_engine.Step(state, child.move);
+                codec.Encode(state, key);
+                if (key == child.key) {
+                    break;
+                }
+            }
+        }
+        std::reverse(moves.begin(), moves.end());
+        return moves;
+    };
+
+    RunSorter sorter(files, options.externalMemory);
+    StateRecord child;
+    for (size_t depth = 0;; ++depth) {
+        // expand the layer into sorted runs of successors
+        RunReader layer(files.Layer(depth));
+        if (!layer.Ok()) {
+            return failed();
+        }
+        while (layer.Read(record)) {
+            if (options.cancel && options.cancel->load(std::memory_order_relaxed)) {
+                return result;
+            }
+            codec.Decode(record.key, state);
+
+            for (const Direction dir : DIRECTIONS) {
+                next = state;
+                if (!m_engine.Step(next, dir)) {
+                    break;
+                }
+                if (next.IsWin()) {
+                    result.solved = true;
+                    result.moves = path(record, depth);
+                    result.moves.push_back(ToChar(dir));
+                    return result;
+                }
+
+                child.key.resize(codec.Words());
+                codec.Encode(next, child.key);
+                if (child.key == record.key) {
+                    continue;
+                }
+                child.hash = HashCompactKey(child.key);
+                child.parent = record.hash;
+                child.move = dir;
+                if (!sorter.Add(child)) {
+                    return failed();
+                }
+            }
+        }
+
+        // drop the duplicates and write the next layer
+        const MergeResult merged =
+            sorter.Merge(files.Visited(depth), files.Visited(depth + 1), files.Layer(depth + 1));
+        if (!merged.ok) {
+            return failed();
+        }
+        numStates += merged.added;
+        result.statesVisited = numStates;
+        if (merged.added == 0) {
+            result.exhausted = true;
+            return result;
+        }
+        if (numStates >= options.maxStates) {
+            return result;
+        }
+    }
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,55 @@
+#include "spill_table.h"
+#include <algorithm>
+#include <cassert>
+
+namespace BabaIsYou {
+
+namespace {
+
+bool TileLess(const SpillTable::Entry& entry, uint16_t tile) {
+    return entry.tile < tile;
+}
+
+} // namespace
+
+std::span<const SpillTable::Entry> SpillTable::At(uint16_t tile) const {
+    const auto first = std::lower_bound(m_entries.begin(), m_entries.end(), tile, TileLess);
+    auto last = first;
+    while (last != m_entries.end() && last->tile == tile) {
+        ++last;
+    }
+    return { first, last };
+}
+
+SpillTable::Entries::iterator SpillTable::First(uint16_t tile) {
+    return std::lower_bound(m_entries.begin(), m_entries.end(), tile, TileLess);
+}
+
+void SpillTable::Push(uint16_t tile, ObjectType type, uint16_t slot) {
+    auto it = First(tile);
+    while (it != m_entries.end() && it->tile == tile) {
+        ++it;
+    }
+    m_entries.insert(it, { tile, slot, type });
+}
+
+bool SpillTable::Remove(uint16_t tile, ObjectType type, uint16_t& slot) {
+    for (auto it = First(tile); it != m_entries.end() && it->tile == tile; ++it) {
+        if (it->type == type) {
+            slot = it->slot;
+            m_entries.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+SpillTable::Entry SpillTable::PopBottom(uint16_t tile) {
+    const auto it = First(tile);
+    assert(it != m_entries.end() && it->tile == tile);
+    const Entry entry = *it;
+    m_entries.erase(it);
+    return entry;
+}
+
+} // namespace BabaIsYou
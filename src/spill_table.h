@@ -0,0 +1,41 @@
+#pragma once
+
+#include "block_pool.h"
+#include "tile.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace BabaIsYou {
+
+// Objects stacked above the MAX_OBJECT_PER_TILE a tile keeps inline, for a whole board. They
+// share one arena, grouped by tile and bottom first within a tile, so a board holds a single
+// allocation however many tiles overflow, and a board with none holds nothing.
+class SpillTable {
+  public:
+    struct Entry {
+        uint16_t tile;
+        uint16_t slot;
+        ObjectType type;
+    };
+
+    // Spilled objects of one tile, bottom first
+    std::span<const Entry> At(uint16_t tile) const;
+    bool IsEmpty() const { return m_entries.empty(); }
+
+    // Puts an object on top of the tile's stack
+    void Push(uint16_t tile, ObjectType type, uint16_t slot);
+    // Removes the lowest spilled object of `type` and hands back its entity slot
+    bool Remove(uint16_t tile, ObjectType type, uint16_t& slot);
+    // Removes the bottom spilled object of the tile, which must have one
+    Entry PopBottom(uint16_t tile);
+
+  private:
+    using Entries = std::vector<Entry, PoolAllocator<Entry>>;
+
+    Entries::iterator First(uint16_t tile);
+
+    Entries m_entries; // sorted by tile
+};
+
+} // namespace BabaIsYou
@@ -0,0 +1,161 @@
+#include "state_graph.h"
+#include "compact_key.h"
+#include "external_sort.h"
+#include "trace.h"
+#include <fstream>
+#include <vector>
+
+namespace BabaIsYou {
+
+namespace {
+
+// Appends little-endian records to a buffer and hands it to the file whenever it fills up
+class EdgeWriter {
+  public:
+    EdgeWriter(std::ofstream& file, size_t bufferBytes) : m_file(file) {
+        m_buffer.reserve(bufferBytes + GRAPH_EDGE_SIZE);
+        m_limit = bufferBytes;
+    }
+
+    void U8(uint8_t value) { m_buffer.push_back(value); }
+    void U16(uint16_t value) {
+        U8(uint8_t(value));
+        U8(uint8_t(value >> 8));
+    }
+    void U32(uint32_t value) {
+        U16(uint16_t(value));
+        U16(uint16_t(value >> 16));
+    }
+    void U64(uint64_t value) {
+        U32(uint32_t(value));
+        U32(uint32_t(value >> 32));
+    }
+
+    void Edge(uint64_t from, uint64_t to, uint8_t move) {
+        U64(from);
+        U64(to);
+        U8(move);
+        if (m_buffer.size() >= m_limit) {
+            Flush();
+        }
+    }
+
+    bool Flush() {
+        TRACE_ZONE("EdgeWriter::Flush");
+        m_file.write(reinterpret_cast<const char*>(m_buffer.data()),
+            std::streamsize(m_buffer.size()));
+        m_buffer.clear();
+        return bool(m_file);
+    }
+
+  private:
+    std::ofstream& m_file;
+    std::vector<uint8_t> m_buffer;
+    size_t m_limit;
+};
+
+} // namespace
+
+GraphExportResult StateGraphExporter::Export(const GameState& start,
+    const std::filesystem::path& path, const GraphExportOptions& options) const {
+    TRACE_ZONE("StateGraphExporter::Export");
+
+    GraphExportResult result;
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return result;
+    }
+    SearchFiles files(options.tempDir.empty() ? std::filesystem::path(path.string() + ".tmp")
+                                              : options.tempDir);
+    if (!files.Open()) {
+        return result;
+    }
+    EdgeWriter writer(file, options.bufferBytes);
+
+    const CompactKeyCodec codec(m_engine, start);
+    StateRecord record;
+    record.key.resize(codec.Words());
+    codec.Encode(start, record.key);
+    record.hash = HashCompactKey(record.key);
+    record.parent = record.hash;
+    writer.U32(GRAPH_MAGIC);
+    writer.U16(GRAPH_VERSION);
+    writer.U16(uint16_t(GRAPH_EDGE_SIZE));
+    writer.U64(record.hash);
+    {
+        RunWriter layer(files.Layer(0));
+        layer.Write(record);
+        RunWriter visited(files.Visited(0));
+        visited.WriteKey(record);
+        if (!layer.Close() || !visited.Close()) {
+            return result;
+        }
+    }
+    result.states = 1;
+
+    // Every layer is read, wins counted, but once maxStates is reached the last one is not
+    // expanded
+    RunSorter sorter(files, options.memoryBytes);
+    bool full = false;
+    GameState state;
+    GameState next;
+    StateRecord child;
+    for (size_t depth = 0;; ++depth) {
+        RunReader layer(files.Layer(depth));
+        if (!layer.Ok()) {
+            return result;
+        }
+        while (layer.Read(record)) {
+            codec.Decode(record.key, state);
+            if (m_engine.CheckWin(state)) {
+                result.wins++;
+                continue;
+            }
+            if (full) {
+                continue;
+            }
+
+            for (const Direction dir : DIRECTIONS) {
+                next = state;
+                if (!m_engine.Step(next, dir)) {
+                    break;
+                }
+                child.key.resize(codec.Words());
+                codec.Encode(next, child.key);
+                if (child.key == record.key) {
+                    continue;
+                }
+                child.hash = HashCompactKey(child.key);
+                child.parent = record.hash;
+                child.move = dir;
+                writer.Edge(record.hash, child.hash,
+                    uint8_t(int(dir) | (next.IsWin() ? GRAPH_EDGE_WIN : 0)));
+                result.edges++;
+                if (!sorter.Add(child)) {
+                    return result;
+                }
+            }
+        }
+        if (full) {
+            break;
+        }
+
+        const MergeResult merged =
+            sorter.Merge(files.Visited(depth), files.Visited(depth + 1), files.Layer(depth + 1));
+        files.Remove(files.Layer(depth));
+        if (!merged.ok) {
+            return result;
+        }
+        if (merged.added == 0) {
+            break;
+        }
+        result.states += merged.added;
+        full = result.states >= options.maxStates;
+    }
+
+    result.complete = !full;
+    result.ok = writer.Flush();
+    return result;
+}
+
+} // namespace BabaIsYou
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "engine.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace BabaIsYou {
+
+constexpr uint32_t GRAPH_MAGIC = 0x47424142; // "BABG"
+constexpr uint16_t GRAPH_VERSION = 2;
+
+// Graph file layout, all integers little-endian:
+//   u32 magic, u16 version, u16 edge record size (17)
+//   u64 hash of the start state
+//   then one record per edge until the end of the file:
+//   u64 hash of the state before, u64 hash of the state after, u8 move
+// where a state's hash is HashCompactKey of its compact key, with the codec built from the start,
+// and the move's low two bits are its Direction;
+// bit 7 is set when the state after is won. Moves that leave the state as it was are not edges.
+// Records are in breadth-first order of the state before, so a state's out-edges are adjacent.
+constexpr uint8_t GRAPH_EDGE_WIN = 0x80;
+constexpr size_t GRAPH_EDGE_SIZE = 17;
+
+struct GraphExportOptions {
+    size_t maxStates = 50'000'000; // stop after the layer that reaches this; the file then holds
+                                   // a partial graph
+    size_t bufferBytes = 1 << 20;  // edges are flushed to the file in chunks of this size
+
+    // Where the layers are kept while enumerating, "<file>.tmp" when empty. Expects a directory
+    // of its own; the files are removed afterwards.
+    std::filesystem::path tempDir;
+    size_t memoryBytes = size_t(256) << 20; // bytes of successors sorted in memory per run
+};
+
+struct GraphExportResult {
+    bool ok = false;       // all files were written; nothing else is meaningful otherwise
+    bool complete = false; // every reachable state was expanded within maxStates
+    size_t states = 0;     // distinct states seen, wins included
+    size_t edges = 0;
+    size_t wins = 0;
+};
+
+// Enumerates a level's reachable state graph breadth first and streams its edges to a file. Edges
+// are written as they are found and never kept. States are kept on disk, as in the solver's
+// external mode: each layer is a file of compact keys, its successors are sorted in runs, and a
+// streaming merge with the sorted keys of all earlier states drops duplicates, by full key, and
+// writes the next layer. Memory stays at memoryBytes for the run being sorted, plus the edge
+// buffer and up to 64 read buffers of 1 MB during a merge, however large the graph. The disk holds
+// the keys of all states seen, twice while a merge rewrites them, and two layers. Won states end
+// the game, so they are not expanded.
+class StateGraphExporter {
+  public:
+    explicit StateGraphExporter(const Engine& engine) : m_engine(engine) {}
+
+    GraphExportResult Export(const GameState& start, const std::filesystem::path& path,
+        const GraphExportOptions& options = {}) const;
+
+  private:
+    const Engine& m_engine;
+};
+
+} // namespace BabaIsYou
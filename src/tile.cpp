@@ -3,24 +3,27 @@
 
 namespace BabaIsYou {
 
-void Tile::Push(ObjectType type) {
+bool Tile::Push(ObjectType type, uint16_t slot) {
+    assert(m_numObjects < MAX_STACK_HEIGHT);
     if (m_numObjects >= MAX_OBJECT_PER_TILE) {
-        return;
+        m_numObjects++;
+        return false;
     }
 
+    m_slots[m_numObjects] = slot;
     m_objects[m_numObjects++] = type;
+    return true;
 }
 
-ObjectType Tile::Pop() {
-    assert(m_numObjects >= 1);
-    return m_objects[--m_numObjects];
-}
-
-bool Tile::Remove(ObjectType type) {
-    for (int i = 0; i < m_numObjects; ++i) {
+// Shifts the inline objects above down; Size() still counts any spilled ones
+bool Tile::Remove(ObjectType type, uint16_t& slot) {
+    const int numInline = int(InlineSize());
+    for (int i = 0; i < numInline; ++i) {
         if (m_objects[i] == type) {
-            for (int j = i; j < m_numObjects - 1; j++) {
+            slot = m_slots[i];
+            for (int j = i; j < numInline - 1; j++) {
                 m_objects[j] = m_objects[j + 1];
+                m_slots[j] = m_slots[j + 1];
             }
 
             m_numObjects--;
@@ -30,6 +33,12 @@ bool Tile::Remove(ObjectType type) {
     return false;
 }
 
+void Tile::Refill(ObjectType type, uint16_t slot) {
+    assert(m_numObjects >= MAX_OBJECT_PER_TILE);
+    m_objects[MAX_OBJECT_PER_TILE - 1] = type;
+    m_slots[MAX_OBJECT_PER_TILE - 1] = slot;
+}
+
 void Tile::Clear() {
     m_numObjects = 0;
 }
@@ -39,7 +48,8 @@ bool Tile::IsEmpty() const {
 }
 
 bool Tile::Contains(ObjectType type) const {
-    for (int i = 0; i < m_numObjects; ++i) {
+    const size_t numInline = InlineSize();
+    for (size_t i = 0; i < numInline; ++i) {
         if (m_objects[i] == type) {
             return true;
         }
@@ -2,15 +2,17 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace BabaIsYou {
 
 constexpr float TILE_PIXEL_SIZE = 48.0f;
-constexpr size_t MAX_OBJECT_PER_TILE = 5;
+constexpr size_t MAX_OBJECT_PER_TILE = 5;   // kept inline in the tile, the rest spill
+constexpr size_t MAX_STACK_HEIGHT = 255;     // objects on one tile in all
 
-enum class ObjectType {
+enum class ObjectType : uint8_t {
     Empty,
     Wall,
     Baba,
@@ -63,22 +65,37 @@ inline std::string TypeToStr(ObjectType type) {
     return str;
 }
 
+// Objects stacked on one tile, bottom first. Each object keeps the slot of its entity in the
+// board's EntityPool next to its type. The bottom MAX_OBJECT_PER_TILE objects are inline, so a
+// tile is 16 bytes; the count covers the whole stack, and the objects above the inline ones live
+// in the board's SpillTable. Iteration and Contains see the inline objects only.
 class Tile {
   public:
-    void Push(ObjectType type);
-    ObjectType Pop();
-    bool Remove(ObjectType type);
+    // Adds an object on top. Returns false when the inline objects are full: the tile still
+    // counts the object, which the caller keeps in the spill table.
+    bool Push(ObjectType type, uint16_t slot);
+    // Removes the lowest inline object of `type` and hands back its entity slot. On a spilled
+    // tile this opens the top inline entry, which the caller fills with Refill.
+    bool Remove(ObjectType type, uint16_t& slot);
+    void Refill(ObjectType type, uint16_t slot);
+    void RemoveSpilled() { m_numObjects--; }
     void Clear();
     bool IsEmpty() const;
+    size_t Size() const { return m_numObjects; }
+    size_t InlineSize() const { return IsSpilled() ? MAX_OBJECT_PER_TILE : m_numObjects; }
+    bool IsSpilled() const { return m_numObjects > MAX_OBJECT_PER_TILE; }
     bool Contains(ObjectType type) const;
     bool Contains(const std::vector<ObjectType>& types) const;
 
     auto begin() const { return m_objects.begin(); }
-    auto end() const { return m_objects.begin() + m_numObjects; }
+    auto end() const { return m_objects.begin() + InlineSize(); }
+    ObjectType TypeAt(size_t i) const { return m_objects[i]; }
+    uint16_t SlotAt(size_t i) const { return m_slots[i]; }
 
   private:
+    std::array<uint16_t, MAX_OBJECT_PER_TILE> m_slots;
     std::array<ObjectType, MAX_OBJECT_PER_TILE> m_objects;
-    int m_numObjects = 0;
+    uint8_t m_numObjects = 0;
 };
 
 } // namespace BabaIsYou
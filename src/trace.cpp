@@ -0,0 +1,118 @@
+#include "trace.h"
+
+#ifdef PROFILE
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace BabaIsYou {
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    int64_t startNs;
+    int64_t durationNs;
+};
+
+// Each thread appends to its own buffer; the registry lock is only taken when a thread records
+// its first zone and when the trace is written.
+struct ThreadBuffer {
+    int tid;
+    std::vector<TraceEvent> events; // at most MAX_TRACE_EVENTS
+    size_t dropped = 0;             // zones that ended with the buffer full
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+// trace timestamps are relative to program start
+const auto g_epoch = std::chrono::steady_clock::now();
+
+TraceRegistry& Registry() {
+    static TraceRegistry registry;
+    return registry;
+}
+
+ThreadBuffer& LocalBuffer() {
+    thread_local ThreadBuffer* buffer = [] {
+        TraceRegistry& registry = Registry();
+        std::lock_guard lock(registry.mutex);
+        auto& b = registry.buffers.emplace_back(std::make_unique<ThreadBuffer>());
+        b->tid = int(registry.buffers.size());
+        b->events.reserve(MAX_TRACE_EVENTS); // never reallocated; pages are touched as it fills
+        return b.get();
+    }();
+    return *buffer;
+}
+
+thread_local bool t_detail = false;
+
+} // namespace
+
+TraceZone::~TraceZone() {
+    if (!m_name) {
+        return;
+    }
+    const auto end = Clock::now();
+    ThreadBuffer& buffer = LocalBuffer();
+    if (buffer.events.size() >= MAX_TRACE_EVENTS) {
+        buffer.dropped++;
+        return;
+    }
+    buffer.events.push_back({ m_name,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(m_start - g_epoch).count(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_start).count() });
+}
+
+void TraceZone::EnableDetail(bool enable) {
+    t_detail = enable;
+}
+
+bool TraceZone::DetailEnabled() {
+    return t_detail;
+}
+
+bool TraceZone::WriteJson(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    TraceRegistry& registry = Registry();
+    std::lock_guard lock(registry.mutex);
+
+    // complete ("X") events, timestamps in microseconds
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    file.setf(std::ios::fixed);
+    file.precision(3);
+    for (const auto& buffer : registry.buffers) {
+        // a full buffer says so in its thread's name
+        if (buffer->dropped > 0) {
+            file << (first ? "\n" : ",\n")
+                 << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+                 << ",\"args\":{\"name\":\"thread " << buffer->tid << ", " << buffer->dropped
+                 << " zones dropped\"}}";
+            first = false;
+        }
+        for (const auto& e : buffer->events) {
+            file << (first ? "\n" : ",\n") << "{\"name\":\"" << e.name
+                 << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                 << ",\"ts\":" << e.startNs / 1000.0 << ",\"dur\":" << e.durationNs / 1000.0
+                 << '}';
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+    return bool(file);
+}
+
+} // namespace BabaIsYou
+
+#endif
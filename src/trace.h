@@ -0,0 +1,68 @@
+#pragma once
+
+// Scoped trace zones written as Chrome trace event JSON (chrome://tracing, ui.perfetto.dev).
+// Zones are only compiled in the Profile configuration; elsewhere the macros expand to nothing.
+//
+// Each thread keeps at most MAX_TRACE_EVENTS zones and counts the ones past that as dropped, so
+// a thread that runs zones in a hot loop, such as a solver, costs bounded memory. Detail zones
+// split a zone into phases too short and too frequent to be worth recording everywhere; they are
+// only recorded on threads that turned them on with TRACE_DETAIL, in practice the game's frame
+// thread.
+
+#ifdef PROFILE
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace BabaIsYou {
+
+constexpr size_t MAX_TRACE_EVENTS = size_t(1) << 18; // per thread, 24 bytes each
+
+class TraceZone {
+  public:
+    // `name` must outlive the trace, in practice a string literal. A zone made with `record`
+    // false costs nothing and leaves no event.
+    explicit TraceZone(const char* name, bool record = true) : m_name(record ? name : nullptr) {
+        if (record) {
+            m_start = Clock::now();
+        }
+    }
+    ~TraceZone();
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+    // Detail zones of the calling thread
+    static void EnableDetail(bool enable);
+    static bool DetailEnabled();
+
+    // Must not race with zones still being recorded on other threads
+    static bool WriteJson(const std::string& path);
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    const char* m_name;
+    Clock::time_point m_start;
+};
+
+} // namespace BabaIsYou
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) ::BabaIsYou::TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_DETAIL_ZONE(name)                                                                  \
+    ::BabaIsYou::TraceZone TRACE_CONCAT(traceZone, __LINE__)(name,                               \
+        ::BabaIsYou::TraceZone::DetailEnabled())
+#define TRACE_DETAIL(enable) ::BabaIsYou::TraceZone::EnableDetail(enable)
+#define TRACE_WRITE(path) ::BabaIsYou::TraceZone::WriteJson(path)
+
+#else
+
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_DETAIL_ZONE(name) ((void)0)
+#define TRACE_DETAIL(enable) ((void)0)
+#define TRACE_WRITE(path) ((void)0)
+
+#endif
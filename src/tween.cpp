@@ -0,0 +1,54 @@
+#include "tween.h"
+#include <algorithm>
+
+namespace BabaIsYou {
+
+void TweenPool::Start(const ChangeSet& changes) {
+    Clear();
+    if (changes.MovesDropped()) {
+        return; // not every object could be followed, so nothing animates
+    }
+    for (const auto& move : changes.Moves()) {
+        if (m_count == MAX_TWEENS) {
+            break;
+        }
+        m_tweens[m_count++] = { move.from, move.to, move.type };
+        m_arriving.set(move.to);
+    }
+}
+
+void TweenPool::Clear() {
+    for (size_t i = 0; i < m_count; ++i) {
+        m_arriving.reset(m_tweens[i].to);
+    }
+    m_count = 0;
+    m_elapsed = 0.0f;
+}
+
+void TweenPool::Advance(float seconds) {
+    if (m_count == 0) {
+        return;
+    }
+    m_elapsed += seconds;
+    if (m_elapsed >= TWEEN_SECONDS) {
+        Clear();
+    }
+}
+
+float TweenPool::Progress() const {
+    const float t = std::min(m_elapsed / TWEEN_SECONDS, 1.0f);
+    return t * (2.0f - t); // ease out
+}
+
+int TweenPool::CountArriving(uint16_t index, ObjectType type) const {
+    if (!m_arriving.test(index)) {
+        return 0;
+    }
+    int count = 0;
+    for (size_t i = 0; i < m_count; ++i) {
+        count += m_tweens[i].to == index && m_tweens[i].type == type;
+    }
+    return count;
+}
+
+} // namespace BabaIsYou
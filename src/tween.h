@@ -0,0 +1,48 @@
+#pragma once
+
+#include "change_set.h"
+#include "game_state.h"
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace BabaIsYou {
+
+constexpr size_t MAX_TWEENS = 256;
+constexpr float TWEEN_SECONDS = 0.08f;
+
+struct Tween {
+    uint16_t from;
+    uint16_t to;
+    ObjectType type;
+};
+
+// Slides the objects of the last move from their old tile to their new one. The game state has
+// already moved, so this is drawing only: a new move finishes whatever is still sliding, and
+// input is never held back. Fixed capacity; moves past it just appear at their new tile.
+class TweenPool {
+  public:
+    // Finishes the tweens in flight and starts one per move in `changes`
+    void Start(const ChangeSet& changes);
+    void Clear();
+    void Advance(float seconds);
+
+    bool IsEmpty() const { return m_count == 0; }
+    std::span<const Tween> Active() const { return { m_tweens.data(), m_count }; }
+
+    // How far along the active tweens are, eased, from 0 to 1
+    float Progress() const;
+
+    // Objects of `type` sliding into tile `index`; draw that many fewer of them there
+    int CountArriving(uint16_t index, ObjectType type) const;
+
+  private:
+    std::array<Tween, MAX_TWEENS> m_tweens;
+    size_t m_count = 0;
+    std::bitset<NUM_TILES> m_arriving; // tiles some tween ends on
+    float m_elapsed = 0.0f;
+};
+
+} // namespace BabaIsYou
@@ -0,0 +1,97 @@
+#include "batch_engine.h"
+#include "session.h"
+#include "test.h"
+#include <cstddef>
+#include <random>
+#include <vector>
+
+// BatchEngine against Engine::Step: random walks on every environment of a batch, each compared
+// with its own GameState tile for tile after every step
+namespace BabaIsYou::Tests {
+
+namespace {
+
+constexpr size_t NUM_ENVS = 37; // two full lane groups and a partial one
+constexpr size_t NUM_STEPS = 2000;
+
+bool SameBoard(const BatchEngine& batch, size_t env, const GameState& gs) {
+    if (batch.Wins()[env] != gs.IsWin()) {
+        return false;
+    }
+    for (int y = 0; y < LEVEL_HEIGHT; ++y) {
+        for (int x = 0; x < LEVEL_WIDTH; ++x) {
+            TileMask mask = 0;
+            for (const auto obj : gs.At(x, y)) {
+                mask |= TileMask(TileMask(1) << int(obj));
+            }
+            if (batch.At(env, x, y) != mask) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void CheckRandomWalks(int level) {
+    Session session;
+    session.SelectLevel(level);
+    const Engine& engine = session.GetEngine();
+    const GameState& start = session.GetState();
+
+    BatchEngine batch(engine, NUM_ENVS);
+    for (size_t env = 0; env < NUM_ENVS; ++env) {
+        if (!batch.SetState(env, start)) {
+            return; // more than one You, which BatchEngine does not take
+        }
+    }
+    std::vector<GameState> states(NUM_ENVS, start);
+
+    // GetState reads back what SetState took
+    GameState read;
+    batch.GetState(0, read);
+    Check(Tiles(read) == Tiles(start), "BatchEngine::GetState differs from SetState", level);
+
+    std::mt19937 rng(4242);
+    std::vector<Direction> actions(NUM_ENVS);
+    bool same = true;
+    for (size_t step = 0; step < NUM_STEPS && same; ++step) {
+        for (auto& action : actions) {
+            action = DIRECTIONS[rng() % DIRECTIONS.size()];
+        }
+        batch.Step(actions);
+        for (size_t env = 0; env < NUM_ENVS; ++env) {
+            engine.Step(states[env], actions[env]);
+            same = same && SameBoard(batch, env, states[env]);
+            if (states[env].IsWin()) {
+                states[env] = start;
+                batch.SetState(env, start);
+            }
+        }
+    }
+    Check(same, "BatchEngine::Step differs from Engine::Step", level);
+
+    // the range overload steps its range only
+    for (auto& action : actions) {
+        action = DIRECTIONS[rng() % DIRECTIONS.size()];
+    }
+    batch.Step(actions, BATCH_LANES, NUM_ENVS);
+    bool ranged = true;
+    for (size_t env = 0; env < NUM_ENVS; ++env) {
+        if (env >= BATCH_LANES) {
+            engine.Step(states[env], actions[env]);
+        }
+        ranged = ranged && SameBoard(batch, env, states[env]);
+    }
+    Check(ranged, "BatchEngine::Step stepped outside its range", level);
+}
+
+} // namespace
+
+void BatchEngineTests() {
+    const int count = Session().GetLevels().Count();
+    for (int level = 0; level < count; ++level) {
+        CheckRandomWalks(level);
+    }
+}
+
+} // namespace BabaIsYou::Tests
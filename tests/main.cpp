@@ -0,0 +1,45 @@
+#include "test.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+namespace BabaIsYou::Tests {
+
+namespace {
+
+int g_failures = 0;
+
+} // namespace
+
+void Check(bool ok, const char* what, int level) {
+    if (!ok) {
+        std::fprintf(stderr, "level %d: %s\n", level, what);
+        g_failures++;
+    }
+}
+
+std::string Tiles(const GameState& gs) {
+    std::string tiles;
+    for (int y = 0; y < LEVEL_HEIGHT; ++y) {
+        for (int x = 0; x < LEVEL_WIDTH; ++x) {
+            const size_t begin = tiles.size();
+            for (const auto obj : gs.At(x, y)) {
+                tiles.push_back(char(obj));
+            }
+            std::sort(tiles.begin() + std::ptrdiff_t(begin), tiles.end());
+            tiles.push_back('|');
+        }
+    }
+    return tiles;
+}
+
+} // namespace BabaIsYou::Tests
+
+int main() {
+    using namespace BabaIsYou::Tests;
+    SolverTests();
+    SessionTests();
+    BatchEngineTests();
+    return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,134 @@
+#include "session.h"
+#include "test.h"
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Session snapshots: Save and Restore round trips and the rejection of malformed ones
+namespace BabaIsYou::Tests {
+
+namespace {
+
+// Exact tile contents, bottom to top, and the win flag
+bool SameState(const GameState& a, const GameState& b) {
+    if (a.IsWin() != b.IsWin()) {
+        return false;
+    }
+    for (int y = 0; y < LEVEL_HEIGHT; ++y) {
+        for (int x = 0; x < LEVEL_WIDTH; ++x) {
+            const TileObjects ta = a.At(x, y);
+            const TileObjects tb = b.At(x, y);
+            if (ta.Size() != tb.Size()) {
+                return false;
+            }
+            for (size_t i = 0; i < ta.Size(); ++i) {
+                if (ta[i] != tb[i]) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool SameRules(const Engine& a, const Engine& b) {
+    for (int property = 0; property < SESSION_PROPERTIES; ++property) {
+        if (a.GetRules().Get(Property(property)) != b.GetRules().Get(Property(property))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Random moves with some undos, more than the history holds, without winning
+void Play(Session& session, size_t turns) {
+    std::mt19937 rng(777);
+    for (size_t i = 0; i < turns; ++i) {
+        if (rng() % 8 == 0) {
+            session.Undo();
+        } else {
+            session.TryMove(DIRECTIONS[rng() % DIRECTIONS.size()]);
+        }
+        if (session.GetState().IsWin()) {
+            session.Undo();
+        }
+    }
+}
+
+void CheckRoundTrip(int level) {
+    Session played;
+    played.SelectLevel(level);
+    Play(played, MAX_HISTORY * 2);
+    played.AddRule(ObjectType::Wall, Property::Push);
+    std::vector<uint8_t> data;
+    played.Save(data);
+
+    Session restored;
+    Check(restored.Restore(data), "Restore rejected a saved session", level);
+    Check(restored.GetLevels().CurrentIndex() == level, "Restore changed the level", level);
+    Check(SameRules(played.GetEngine(), restored.GetEngine()), "Restore changed the rules",
+        level);
+
+    // every undo, and the one past the end of the history, lands on the same state
+    bool same = true;
+    for (size_t i = 0; i <= MAX_HISTORY + 1; ++i) {
+        same = same && SameState(played.GetState(), restored.GetState());
+        played.Undo();
+        restored.Undo();
+    }
+    Check(same, "the restored session undoes to other states", level);
+}
+
+void CheckRejects(int level) {
+    Session played;
+    played.SelectLevel(level);
+    Play(played, 50);
+    std::vector<uint8_t> data;
+    played.Save(data);
+
+    Session session;
+    session.SelectLevel(level);
+    session.TryMove(Direction::Down);
+    const GameState before = session.GetState();
+    auto rejects = [&](const std::vector<uint8_t>& bad) {
+        return !session.Restore(bad) && SameState(session.GetState(), before) &&
+            session.GetLevels().CurrentIndex() == level;
+    };
+
+    bool truncated = true;
+    for (size_t size = 0; size < data.size(); ++size) {
+        const std::vector<uint8_t> bad(data.begin(), data.begin() + std::ptrdiff_t(size));
+        truncated = truncated && rejects(bad);
+    }
+    Check(truncated, "Restore accepted a truncated snapshot", level);
+
+    std::vector<uint8_t> bad = data;
+    bad[0] ^= 0xFF;
+    Check(rejects(bad), "Restore accepted a snapshot with a bad magic", level);
+
+    bad = data;
+    bad[4] = uint8_t(SESSION_VERSION + 1);
+    Check(rejects(bad), "Restore accepted a snapshot of another version", level);
+
+    bad = data;
+    bad[6] = uint8_t(session.GetLevels().Count());
+    bad[7] = 0;
+    Check(rejects(bad), "Restore accepted a snapshot of a level out of range", level);
+
+    bad = data;
+    bad.push_back(0);
+    Check(rejects(bad), "Restore accepted a snapshot with trailing bytes", level);
+}
+
+} // namespace
+
+void SessionTests() {
+    const int count = Session().GetLevels().Count();
+    for (int level = 0; level < count; ++level) {
+        CheckRoundTrip(level);
+        CheckRejects(level);
+    }
+}
+
+} // namespace BabaIsYou::Tests
@@ -0,0 +1,102 @@
+#include "compact_key.h"
+#include "session.h"
+#include "solver.h"
+#include "test.h"
+#include <cstddef>
+#include <iterator>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+// The solver modes and the compact key codec
+namespace BabaIsYou::Tests {
+
+namespace {
+
+constexpr size_t SHORTEST[] = { 13, 4, 4 }; // shortest solution of each built-in level
+
+// True if `moves` wins `level` when played from its start
+bool Wins(int level, const std::string& moves) {
+    Session session;
+    session.SelectLevel(level);
+    const BatchResult result = session.ApplyMoves(moves);
+    return result.valid && result.applied == moves.size() && result.won;
+}
+
+void CheckSolve(const Session& session, int level) {
+    const Solver solver(session.GetEngine());
+
+    SolverOptions options;
+    const SolverResult plain = solver.Solve(session.GetState(), options);
+    Check(plain.solved && Wins(level, plain.moves), "plain search found no winning solution",
+        level);
+    Check(plain.moves.size() == SHORTEST[level], "plain search solution is not the shortest",
+        level);
+
+    options.bidirectional = true;
+    const SolverResult bidirectional = solver.Solve(session.GetState(), options);
+    Check(bidirectional.solved && Wins(level, bidirectional.moves),
+        "bidirectional search found no winning solution", level);
+    Check(bidirectional.moves.size() >= SHORTEST[level],
+        "bidirectional search solution is shorter than the shortest", level);
+
+    options.bidirectional = false;
+    options.externalDir = std::filesystem::temp_directory_path() /
+        ("baba-solver-test-" + std::to_string(level));
+    options.externalMemory = 4096; // many small runs, so spilling and compaction are exercised
+    const SolverResult external = solver.Solve(session.GetState(), options);
+    Check(!external.failed, "external search could not use its directory", level);
+    Check(external.solved && Wins(level, external.moves),
+        "external search found no winning solution", level);
+    Check(external.moves.size() == SHORTEST[level],
+        "external search solution is not the shortest", level);
+    Check(!std::filesystem::exists(options.externalDir),
+        "external search left its directory behind", level);
+}
+
+// Encode, decode and encode again gives the same key, and the decoded state the same tiles
+void CheckRoundTrip(const GameState& gs, const CompactKeyCodec& codec, int level) {
+    std::vector<uint64_t> key(codec.Words());
+    std::vector<uint64_t> again(codec.Words());
+    codec.Encode(gs, key);
+    GameState decoded;
+    codec.Decode(key, decoded);
+    codec.Encode(decoded, again);
+    Check(key == again, "compact key changed through decode and encode", level);
+
+    Check(Tiles(gs) == Tiles(decoded), "decoded state differs from the encoded one", level);
+    Check(!decoded.IsWin(), "decoded state has the win flag set", level);
+}
+
+void CheckCompactKey(const Session& session, int level) {
+    const Engine& engine = session.GetEngine();
+    const CompactKeyCodec codec(engine, session.GetState());
+
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> pick(0, int(DIRECTIONS.size()) - 1);
+    GameState state = session.GetState();
+    CheckRoundTrip(state, codec, level);
+    for (int i = 0; i < 200 && !state.IsWin(); ++i) {
+        engine.Step(state, DIRECTIONS[pick(rng)]);
+        CheckRoundTrip(state, codec, level);
+    }
+}
+
+} // namespace
+
+void SolverTests() {
+    Session session;
+    const int count = session.GetLevels().Count();
+    if (count != int(std::size(SHORTEST))) {
+        Check(false, "the built-in levels do not match SHORTEST", count);
+        return;
+    }
+    for (int level = 0; level < count; ++level) {
+        session.SelectLevel(level);
+        CheckSolve(session, level);
+        CheckCompactKey(session, level);
+    }
+}
+
+} // namespace BabaIsYou::Tests
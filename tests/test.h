@@ -0,0 +1,20 @@
+#pragma once
+
+#include "game_state.h"
+#include <string>
+
+// The BabaTests cases. Each checks the built-in levels and reports failures through Check; main
+// runs them all and exits with 1 if any check failed.
+namespace BabaIsYou::Tests {
+
+// Prints `what` for `level` when `ok` is false, and counts it
+void Check(bool ok, const char* what, int level);
+
+// Every tile's objects, sorted within a tile so that stacking order does not count
+std::string Tiles(const GameState& gs);
+
+void SolverTests();
+void SessionTests();
+void BatchEngineTests();
+
+} // namespace BabaIsYou::Tests